@@ -0,0 +1,219 @@
+#pragma once
+
+#include <vector>
+#include <stdexcept>
+
+#include "rng.h"
+#include "data_model.h"
+#include "data_importing.h"
+#include "allocations.h"
+
+using std::vector;
+
+
+
+namespace ai{
+    using namespace data_model;
+    using data_importing::find_matchup;
+
+    /// Complete turn of one side: an action and, for reselection, the selected creature.
+    struct move_t{
+        player_action action;
+        /// Index of the selected creature (only for creature_reselection).
+        int selection_index;
+    };
+
+    bool operator==(const move_t& a, const move_t& b){
+        return a.action == b.action && a.selection_index == b.selection_index;
+    }
+
+    // Helpers taking the game are templates: the simulation and the search pass game_status_t, whose final classes
+    // bind every call statically and inline it, while the console passes game_status_i.
+
+    /// Gets contemporary team of given side of the fight.
+    /// @tparam game_t game_status_t or game_status_i.
+    /// @param game_status Contemporary game status.
+    /// @param player_team Informs if the player's team is mentioned.
+    /// @return Fighting team.
+    template<class game_t>
+    auto get_team(game_t* game_status, bool player_team){
+        return player_team ? game_status->get_player_team() : game_status->get_current_enemy_team();
+    }
+
+    /// Picks a weighted random action for given side of the fight.
+    /// @tparam game_t game_status_t or game_status_i.
+    /// @param game_status Contemporary game status.
+    /// @param player_team Informs if the action is picked for the player's team.
+    /// @param random Random stream of the bot.
+    /// @return Selected action.
+    template<class game_t>
+    player_action get_action(game_t* game_status, bool player_team, rng::context_t& random){
+        allocations::scope_t scope(allocations::subsystem::ai);
+        vector<player_action> results;
+
+        if(game_status->can_make_turn_use_attack(player_team)){
+            results.push_back(player_action::attack);
+            results.push_back(player_action::attack);
+            results.push_back(player_action::attack);
+        }
+        if(game_status->can_make_turn_use_skill(player_team)){
+            results.push_back(player_action::skill_use);
+            results.push_back(player_action::skill_use);
+        }
+        if(game_status->can_make_turn_evolute(player_team)){
+            results.push_back(player_action::evolution);
+            results.push_back(player_action::evolution);
+            results.push_back(player_action::evolution);
+            results.push_back(player_action::evolution);
+            results.push_back(player_action::evolution);
+        }
+        if(get_team(game_status, player_team)->get_selectable_creature_count() > 1){
+            results.push_back(player_action::creature_reselection);
+        }
+
+        int random_index = random.next_index(results.size());
+        return results.at(random_index);
+    }
+
+    /// Picks a random living creature (other than the one on the arena) for given side of the fight.
+    /// @tparam game_t game_status_t or game_status_i.
+    /// @param game_status Contemporary game status.
+    /// @param player_team Informs if the selection is picked for the player's team.
+    /// @param random Random stream of the bot.
+    /// @return Index of the selected creature.
+    template<class game_t>
+    int get_selection(game_t* game_status, bool player_team, rng::context_t& random) {
+        allocations::scope_t scope(allocations::subsystem::ai);
+        auto team = get_team(game_status, player_team);
+
+        vector<int> selectables;
+
+        for (int i = 0; i < team->get_creature_count(); ++i) {
+            if(team->get_selected_creature() == team->get_creature(i))
+                continue;
+            if(team->is_creature_selectable(i))
+                selectables.push_back(i);
+        }
+
+        if(selectables.empty())
+            throw std::invalid_argument("Selectables it empty!");
+
+        int random_index = random.next_index(selectables.size());
+        return selectables.at(random_index);
+    }
+
+    /// Lists moves legal for given side of the fight. Obligatory turns are not considered.
+    /// @tparam game_t game_status_t or game_status_i.
+    /// @param game_status Contemporary game status.
+    /// @param player_team Informs if the moves are listed for the player's team.
+    /// @param moves Overwritten list of the moves.
+    template<class game_t>
+    void list_moves(game_t* game_status, bool player_team, vector<move_t>& moves){
+        moves.clear();
+        if(game_status->can_make_turn_use_attack(player_team))
+            moves.push_back({player_action::attack, -1});
+        if(game_status->can_make_turn_use_skill(player_team))
+            moves.push_back({player_action::skill_use, -1});
+        if(game_status->can_make_turn_evolute(player_team))
+            moves.push_back({player_action::evolution, -1});
+
+        auto team = get_team(game_status, player_team);
+        for (int i = 0; i < (int) team->get_creature_count(); ++i) {
+            if(i != team->get_selected_creature_index() && team->is_creature_selectable(i))
+                moves.push_back({player_action::creature_reselection, i});
+        }
+    }
+
+    /// Makes the move of given side of the fight.
+    /// @tparam game_t game_status_t or game_status_i.
+    /// @param game_status Contemporary game status.
+    /// @param player_team Informs if the move is made by the player's team.
+    /// @param move Legal move.
+    template<class game_t>
+    void apply_move(game_t* game_status, bool player_team, const move_t& move){
+        switch (move.action) {
+            case player_action::attack: game_status->make_turn_use_attack(player_team); break;
+            case player_action::skill_use: game_status->make_turn_use_skill(player_team); break;
+            case player_action::evolution: game_status->make_turn_evolute(player_team); break;
+            case player_action::creature_reselection: game_status->make_turn_select_creature(player_team, move.selection_index); break;
+            default: break;
+        }
+    }
+
+    /// Share of health the team has left.
+    /// @tparam team_type_t team_t or team_i.
+    /// @param team Judged team.
+    /// @return Sum of health divided by sum of max health of its creatures.
+    template<class team_type_t>
+    float get_health_ratio(team_type_t* team){
+        float health = 0, max_health = 0;
+        for (int i = 0; i < (int) team->get_creature_count(); ++i) {
+            auto creature = team->get_creature(i);
+            health += creature->get_health();
+            max_health += creature->get_evolution()->max_health;
+        }
+        return max_health > 0 ? health / max_health : 0;
+    }
+
+    /// Judges the current round from the player's perspective.
+    /// @tparam game_t game_status_t or game_status_i.
+    /// @param game_status Contemporary game status.
+    /// @return 1 for won round, 0 for lost one, share of remaining health for unfinished one.
+    template<class game_t>
+    float evaluate_round(game_t* game_status){
+        if(game_status->get_current_enemy_team()->is_defeated()) return 1;
+        if(game_status->get_player_team()->is_defeated()) return 0;
+
+        float player = get_health_ratio(game_status->get_player_team());
+        float enemy = get_health_ratio(game_status->get_current_enemy_team());
+        return player + enemy > 0 ? player / (player + enemy) : 0.5f;
+    }
+
+    /// @return Catalog index of the creature evolution.
+    /// @tparam creature_type_t creature_t or creature_i.
+    template<class creature_type_t>
+    int get_evolution_index(creature_type_t* creature){
+        return (int) (creature->get_evolution() - data_importing::catalog->evolutions);
+    }
+
+    /// Judges a duel of default attacks from the perspective of creature A.
+    /// @param evolution_a Catalog index of the evolution of A.
+    /// @param health_a Health of A.
+    /// @param evolution_b Catalog index of the evolution of B.
+    /// @param health_b Health of B.
+    /// @return Share of the attacks B needs to kill A out of the attacks both of them need.
+    float evaluate_duel(int evolution_a, float health_a, int evolution_b, float health_b){
+        const float damage_a = find_matchup(evolution_a, evolution_b).expected_damage;
+        const float damage_b = find_matchup(evolution_b, evolution_a).expected_damage;
+        if(damage_a <= 0 || damage_b <= 0)
+            return damage_a > 0 ? 1.0f : damage_b > 0 ? 0.0f : 0.5f;
+
+        const float attacks_a = health_b / damage_a;
+        const float attacks_b = health_a / damage_b;
+        return attacks_b / (attacks_a + attacks_b);
+    }
+
+    /// Rates a creature as a pick by its default evolution dueling default evolutions of all creatures.
+    /// @param pick Rated creature.
+    /// @return Average duel value in [0, 1].
+    float rate_pick(const creature_meta_t* pick){
+        auto catalog = data_importing::catalog;
+        const evolution_meta_t& evolution = catalog->evolutions[pick->first_evolution];
+
+        float sum = 0;
+        for (int c = 0; c < catalog->creature_count; ++c) {
+            const int opponent = catalog->creatures[c].first_evolution;
+            sum += evaluate_duel(pick->first_evolution, evolution.max_health,
+                                 opponent, catalog->evolutions[opponent].max_health);
+        }
+        return catalog->creature_count > 0 ? sum / (float) catalog->creature_count : 0;
+    }
+
+    player_action get_enemy_action(game_status_i* game_status, rng::context_t& random){
+        return get_action(game_status, false, random);
+    }
+
+    int get_enemy_selection(game_status_i* game_status, rng::context_t& random) {
+        return get_selection(game_status, false, random);
+    }
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <ostream>
+
+using std::uint64_t;
+
+
+
+/// Opt-in accounting of heap allocations. With TURNS_GAME_ALLOCATION_TRACKING=1 this header replaces the global
+/// operator new and delete, so it may only be compiled into one translation unit of a program, as every target
+/// of this project is. Allocations are attributed to the subsystem of the innermost scope_t of the thread.
+namespace allocations{
+#ifndef TURNS_GAME_ALLOCATION_TRACKING
+    /// Replaces the global operator new and delete with counting ones. Off by default.
+    #define TURNS_GAME_ALLOCATION_TRACKING 0
+#endif
+
+    constexpr bool tracking_enabled = TURNS_GAME_ALLOCATION_TRACKING != 0;
+
+    /// Owners of allocations.
+    enum class subsystem{
+        /// Allocations made outside of any scope.
+        unattributed = 0,
+        /// Game status, teams and turns, undo records included.
+        engine = 1,
+        ai = 2,
+        serialization = 3,
+        data_importing = 4,
+        /// Subscriptions of listeners.
+        events = 5,
+        /// Dialogs of the console game.
+        console = 6,
+    };
+    constexpr int subsystem_count = 7;
+    constexpr const char* subsystem_names[subsystem_count] {
+        "unattributed", "engine", "ai", "serialization", "data_importing", "events", "console"
+    };
+
+    struct counts_t{
+        uint64_t allocations;
+        uint64_t bytes;
+    };
+
+    /// Allocations of all threads at one moment. Subtracting an earlier report gives allocations in between.
+    struct report_t{
+        counts_t subsystems[subsystem_count];
+        uint64_t deallocations;
+
+        const counts_t& get(subsystem id) const { return subsystems[(int) id]; }
+
+        counts_t get_total() const {
+            counts_t result{0, 0};
+            for (const auto& counts : subsystems) {
+                result.allocations += counts.allocations;
+                result.bytes += counts.bytes;
+            }
+            return result;
+        }
+
+        report_t operator-(const report_t& earlier) const {
+            report_t result{};
+            for (int s = 0; s < subsystem_count; ++s) {
+                result.subsystems[s] = {subsystems[s].allocations - earlier.subsystems[s].allocations,
+                                        subsystems[s].bytes - earlier.subsystems[s].bytes};
+            }
+            result.deallocations = deallocations - earlier.deallocations;
+            return result;
+        }
+    };
+
+    namespace internal{
+        using cell_t = std::atomic<uint64_t>;
+
+        struct shard_t{
+            cell_t allocations[subsystem_count];
+            cell_t bytes[subsystem_count];
+            cell_t deallocations;
+        };
+
+        /// Threads with own shards. Any further threads share the overflow shard.
+        constexpr int max_shards = 256;
+
+        std::atomic<shard_t*> shards[max_shards];
+        std::atomic<int> shard_count{0};
+        shard_t overflow_shard;
+
+        thread_local shard_t* thread_shard = nullptr;
+        thread_local subsystem current_subsystem = subsystem::unattributed;
+
+        /// Takes a shard for the calling thread. Uses malloc, as operator new would count itself.
+        shard_t* register_shard(){
+            const int index = shard_count.fetch_add(1);
+            void* memory = index < max_shards ? std::calloc(1, sizeof(shard_t)) : nullptr;
+            if(memory == nullptr)
+                return thread_shard = &overflow_shard;
+
+            thread_shard = new (memory) shard_t();
+            shards[index].store(thread_shard, std::memory_order_release);
+            return thread_shard;
+        }
+
+        // Counting uses atomic additions, since threads may share the overflow shard.
+        inline void count_allocation(size_t size){
+            shard_t* shard = thread_shard != nullptr ? thread_shard : register_shard();
+            shard->allocations[(int) current_subsystem].fetch_add(1, std::memory_order_relaxed);
+            shard->bytes[(int) current_subsystem].fetch_add(size, std::memory_order_relaxed);
+        }
+
+        inline void count_deallocation(){
+            shard_t* shard = thread_shard != nullptr ? thread_shard : register_shard();
+            shard->deallocations.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /// Attributes allocations of the calling thread to the subsystem while alive. Scopes nest.
+    class scope_t{
+#if TURNS_GAME_ALLOCATION_TRACKING
+    private:
+        subsystem m_previous;
+
+    public:
+        explicit scope_t(subsystem id) : m_previous(internal::current_subsystem) {
+            internal::current_subsystem = id;
+        }
+        ~scope_t(){ internal::current_subsystem = m_previous; }
+#else
+    public:
+        explicit scope_t(subsystem) {}
+#endif
+
+        scope_t(const scope_t&) = delete;
+        scope_t& operator=(const scope_t&) = delete;
+    };
+
+    /// Sums allocations of all threads so far. Zero when tracking is compiled out.
+    /// @return Current counts.
+    report_t take_report(){
+        report_t result{};
+        const int count = std::min(internal::shard_count.load(), internal::max_shards);
+        for (int i = 0; i <= count; ++i) {
+            const internal::shard_t* shard = i < count ?
+                    internal::shards[i].load(std::memory_order_acquire) : &internal::overflow_shard;
+            if(shard == nullptr) continue;
+            for (int s = 0; s < subsystem_count; ++s) {
+                result.subsystems[s].allocations += shard->allocations[s].load(std::memory_order_relaxed);
+                result.subsystems[s].bytes += shard->bytes[s].load(std::memory_order_relaxed);
+            }
+            result.deallocations += shard->deallocations.load(std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    /// Writes allocations by subsystem, and their averages per game and per turn.
+    /// @param o Output stream.
+    /// @param report Allocations made by the games.
+    /// @param games Number of the games. Zero leaves the average out.
+    /// @param turns Number of turns of the games. Zero leaves the average out.
+    void write_text(std::ostream& o, const report_t& report, long long games, long long turns){
+        auto write_counts = [&o](const char* label, const counts_t& counts){
+            o << label << ": " << counts.allocations << " allocations, " << counts.bytes << " B\n";
+        };
+
+        for (int s = 0; s < subsystem_count; ++s) {
+            write_counts(subsystem_names[s], report.subsystems[s]);
+        }
+        const counts_t total = report.get_total();
+        write_counts("total", total);
+        o << "deallocations: " << report.deallocations << '\n';
+
+        if(games > 0)
+            o << "per game: " << (double) total.allocations / (double) games << " allocations, "
+              << (double) total.bytes / (double) games << " B\n";
+        if(turns > 0)
+            o << "per turn: " << (double) total.allocations / (double) turns << " allocations, "
+              << (double) total.bytes / (double) turns << " B\n";
+    }
+}
+
+#if TURNS_GAME_ALLOCATION_TRACKING
+// The replacements pair malloc with free. GCC inlines them into callers and then reports each free as releasing memory
+// of operator new, which it does not know was replaced.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+void* operator new(size_t size){
+    allocations::internal::count_allocation(size);
+    if(void* result = std::malloc(size > 0 ? size : 1)) return result;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size){
+    allocations::internal::count_allocation(size);
+    if(void* result = std::malloc(size > 0 ? size : 1)) return result;
+    throw std::bad_alloc();
+}
+void operator delete(void* pointer) noexcept {
+    if(pointer != nullptr) allocations::internal::count_deallocation();
+    std::free(pointer);
+}
+void operator delete[](void* pointer) noexcept {
+    if(pointer != nullptr) allocations::internal::count_deallocation();
+    std::free(pointer);
+}
+void operator delete(void* pointer, size_t) noexcept { operator delete(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { operator delete[](pointer); }
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
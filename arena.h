@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+
+
+namespace memory{
+    /// Single contiguous block of memory handing out space for objects of one owner (e.g. a game).
+    /// The whole block is allocated once and released at once; objects are never destroyed one by one.
+    class arena_t{
+    private:
+        std::unique_ptr<unsigned char[]> m_block;
+        size_t m_size = 0;
+        size_t m_used = 0;
+
+    public:
+        arena_t() = default;
+
+        /// Allocates the block.
+        /// @param size Size of the block in bytes. Use footprint to compute it.
+        explicit arena_t(size_t size) : m_block(new unsigned char[size]), m_size(size) {}
+
+        arena_t(arena_t&&) noexcept = default;
+        arena_t& operator=(arena_t&&) noexcept = default;
+
+        /// Computes space required to allocate given number of objects, including the worst-case alignment padding.
+        /// @tparam t Type of the objects.
+        /// @param count Number of the objects.
+        /// @return Size in bytes.
+        template<class t>
+        static constexpr size_t footprint(size_t count){
+            return count * sizeof(t) + alignof(t) - 1;
+        }
+
+        /// Reserves uninitialized space for given number of objects (or throws exception when the block is too small).
+        /// @tparam t Type of the objects. Must be trivially destructible, as the arena never calls destructors.
+        /// @param count Number of the objects.
+        /// @return Pointer to the first object.
+        template<class t>
+        t* allocate(size_t count){
+            static_assert(std::is_trivially_destructible<t>::value, "Arena objects are never destroyed.");
+
+            size_t address = reinterpret_cast<size_t>(m_block.get() + m_used);
+            size_t padding = (alignof(t) - address % alignof(t)) % alignof(t);
+
+            if(m_used + padding + count * sizeof(t) > m_size)
+                throw std::length_error("Arena block is too small.");
+
+            auto result = reinterpret_cast<t*>(m_block.get() + m_used + padding);
+            m_used += padding + count * sizeof(t);
+            return result;
+        }
+
+        /// @return Size of the block in bytes.
+        size_t get_size() const { return m_size; }
+        /// @return Bytes handed out so far.
+        size_t get_used() const { return m_used; }
+    };
+}
@@ -0,0 +1,227 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <filesystem>
+
+#include "rng.h"
+#include "data_model.h"
+#include "data_importing.h"
+#include "logic.h"
+#include "ai.h"
+#include "binary_serialization.h"
+#include "simulation.h"
+#include "benchmark.h"
+
+using std::string;
+using std::cout;
+using std::endl;
+using std::vector;
+
+
+
+using namespace data_model;
+using namespace data_importing;
+using namespace logic;
+using namespace benchmark;
+
+
+constexpr uint64_t bench_seed = 7;
+/// Prefix of the temporary save, which ends with a random number, so it never overwrites a save of the player.
+const string bench_save_prefix = "bench_";
+
+/// Silences the console output of the engine (save_game reports every save) while alive.
+class silence_t{
+private:
+    std::ostringstream m_discarded;
+    std::streambuf* m_previous;
+
+public:
+    silence_t() : m_previous(cout.rdbuf(m_discarded.rdbuf())) {}
+    ~silence_t(){ cout.rdbuf(m_previous); }
+};
+
+/// Creates game of the player's team against one enemy team, both of the same size and fully healed. One creature
+/// per team makes a duel; larger teams give the massive skill several targets.
+/// @param player_evolution Catalog index of the evolution of every player's creature.
+/// @param enemy_evolution Catalog index of the evolution of every enemy creature.
+/// @param team_size Number of creatures of each team.
+/// @return New game instance.
+game_status_t* create_duel(int player_evolution, int enemy_evolution, int team_size){
+    auto game = new game_status_t(true, 0, 0, 2, 2 * team_size, nullptr);
+    auto player_team = game->append_team(0);
+    for (int c = 0; c < team_size; ++c) {
+        game->append_creature(player_team, player_evolution, catalog->evolutions[player_evolution].max_health, 0);
+    }
+    auto enemy_team = game->append_team(0);
+    for (int c = 0; c < team_size; ++c) {
+        game->append_creature(enemy_team, enemy_evolution, catalog->evolutions[enemy_evolution].max_health, 0);
+    }
+    return game;
+}
+
+/// Heals every creature of the team back to its full health, without changing its evolution or experience.
+void heal_team(game_status_t* game, team_t* team){
+    for (int c = 0; c < (int) team->get_creature_count(); ++c) {
+        auto creature = team->get_creature_mutable(c);
+        game->set_creature_state(creature, {creature->get_evolution_index(), creature->get_evolution()->max_health, 0});
+    }
+}
+
+void bench_element_damage_mul(vector<result_t>& results, double min_seconds){
+    const element elements[] { element::water, element::earth, element::air, element::fire, element::ice, element::metal };
+    unsigned pair = 0;
+    results.push_back(measure("find_element_damage_mul", min_seconds, [&](){
+        keep(find_element_damage_mul(elements[pair % 6], elements[(pair / 6) % 6]));
+        pair++;
+    }));
+}
+
+void bench_attacks(vector<result_t>& results, double min_seconds){
+    const int evolution = catalog->creatures[0].first_evolution;
+    std::unique_ptr<game_status_t> game(create_duel(evolution, evolution, 1));
+    auto target = game->get_enemy_team_mutable(0)->get_creature_mutable(0);
+    const creature_state_t healthy = target->get_state();
+
+    // The target is healed after every attack, so it never dies; healing is part of the measurement.
+    results.push_back(measure("make_turn_use_attack (damage_default_attack, true_attack)", min_seconds, [&](){
+        game->make_turn_use_attack(true, false);
+        game->set_creature_state(target, healthy);
+    }));
+    results.push_back(measure("make_turn_use_attack dodged", min_seconds, [&](){
+        game->make_turn_use_attack(true, true);
+    }));
+}
+
+void bench_skills(vector<result_t>& results, double min_seconds){
+    const skill_type skill_types[] { skill_type::massive_damage, skill_type::max_hp_ratio_damage, skill_type::hp_ratio_damage };
+    const char* skill_names[] { "massive_damage", "max_hp_ratio_damage", "hp_ratio_damage" };
+    const int target_evolution = catalog->creatures[0].first_evolution;
+
+    for (int s = 0; s < 3; ++s) {
+        int evolution = no_evolution;
+        for (int e = 0; e < catalog->evolution_count && evolution == no_evolution; ++e) {
+            if(catalog->evolutions[e].skill_type == skill_types[s]) evolution = e;
+        }
+        if(evolution == no_evolution) continue;
+
+        // Massive damage hurts the team of the attacker, so both teams are healed after every use.
+        std::unique_ptr<game_status_t> game(create_duel(evolution, target_evolution, 3));
+        results.push_back(measure(string("make_turn_use_skill ") + skill_names[s], min_seconds, [&](){
+            game->make_turn_use_skill(true);
+            heal_team(game.get(), game->get_player_team_mutable());
+            heal_team(game.get(), game->get_enemy_team_mutable(0));
+        }));
+    }
+}
+
+void bench_enemy_action(vector<result_t>& results, double min_seconds){
+    rng::context_t random(bench_seed);
+    auto difficulty = &catalog->difficulties[catalog->difficulty_count - 1];
+    auto picks = simulation::pick_random_team(difficulty->player_count, random);
+    game_status_t game(&picks, difficulty, &random);
+
+    game_status_i* console_game = &game;
+    results.push_back(measure("ai::get_enemy_action (game_status_i)", min_seconds, [&](){
+        keep(ai::get_enemy_action(console_game, random));
+    }));
+    results.push_back(measure("ai::get_action (game_status_t)", min_seconds, [&](){
+        keep(ai::get_action(&game, false, random));
+    }));
+}
+
+void bench_loaders(vector<result_t>& results, double min_seconds){
+    // Loaders fill local storage, so the catalog in use stays untouched.
+    results.push_back(measure("load_difficulties", min_seconds, [](){
+        catalog_storage_t storage;
+        load_difficulties(storage);
+    }));
+    results.push_back(measure("load_creatures", min_seconds, [](){
+        catalog_storage_t storage;
+        load_creatures(storage);
+    }));
+    results.push_back(measure("load catalog (difficulties, creatures, evolutions, seal)", min_seconds, [](){
+        catalog_storage_t storage;
+        load_difficulties(storage);
+        load_creatures(storage);
+        load_evolutions(storage);
+        keep(storage.seal());
+    }));
+    results.push_back(measure("load_element_interactions", min_seconds, [](){
+        load_element_interactions();
+    }));
+}
+
+/// Measures saving and opening of a temporary save, removed afterwards, like the directory when created for it.
+void bench_saves(vector<result_t>& results, double min_seconds){
+    const bool created_directory = std::filesystem::create_directories("Saves");
+    const string bench_save_name = bench_save_prefix + std::to_string(rng::random_seed());
+
+    rng::context_t random(bench_seed);
+    auto difficulty = &catalog->difficulties[catalog->difficulty_count - 1];
+    auto picks = simulation::pick_random_team(difficulty->player_count, random);
+    game_status_t game(&picks, difficulty, &random);
+
+    silence_t silence;
+    results.push_back(measure("save_game + open_game (text)", min_seconds, [&](){
+        serialization::save_game(bench_save_name, &game);
+        delete serialization::open_game(bench_save_name, &random);
+    }));
+    results.push_back(measure("save_game_binary + open_game_binary", min_seconds, [&](){
+        serialization::save_game_binary(bench_save_name, &game);
+        delete serialization::open_game_binary(bench_save_name, &random);
+    }));
+
+    std::filesystem::remove("Saves/" + bench_save_name + ".txt");
+    std::filesystem::remove("Saves/" + bench_save_name + ".bin");
+    if(created_directory) std::filesystem::remove("Saves");
+}
+
+void bench_games(vector<result_t>& results, double min_seconds){
+    for (int d = 0; d < catalog->difficulty_count; ++d) {
+        auto difficulty = &catalog->difficulties[d];
+        rng::context_t random(bench_seed);
+        simulation::batch_result_t batch{};
+        results.push_back(measure("simulated game " + string(difficulty->name), min_seconds, [&](){
+            simulation::run_batch(1, difficulty, random, batch);
+        }));
+    }
+}
+
+void show_results(const vector<result_t>& results){
+    for (const auto& result : results) {
+        cout << std::left << std::setw(64) << result.name
+             << std::right << std::fixed << std::setprecision(1) << std::setw(14) << result.get_ns_per_op() << " ns/op"
+             << std::setw(16) << std::setprecision(0) << result.get_ops_per_second() << " op/s" << endl;
+    }
+}
+
+int main(int argc, char** argv) {
+    string output_file_name = argc > 1 ? argv[1] : "bench_results.json";
+    double min_seconds = argc > 2 ? std::stod(argv[2]) : 0.2;
+
+    init_module_importing_data_from_files();
+
+    vector<result_t> results;
+    bench_element_damage_mul(results, min_seconds);
+    bench_attacks(results, min_seconds);
+    bench_skills(results, min_seconds);
+    bench_enemy_action(results, min_seconds);
+    bench_loaders(results, min_seconds);
+    bench_saves(results, min_seconds);
+    bench_games(results, min_seconds);
+
+    show_results(results);
+
+    std::ofstream o(output_file_name);
+    if(!o.is_open()){
+        cout << "Can not write " << output_file_name << "." << endl;
+        return 1;
+    }
+    write_json(o, results);
+    cout << "Results written to " << output_file_name << "." << endl;
+    return 0;
+}
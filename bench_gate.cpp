@@ -0,0 +1,255 @@
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+// The gate counts allocations of the measured games.
+#define TURNS_GAME_ALLOCATION_TRACKING 1
+
+#include "allocations.h"
+#include "rng.h"
+#include "data_model.h"
+#include "data_importing.h"
+#include "logic.h"
+#include "simulation.h"
+#include "benchmark.h"
+
+using std::string;
+using std::cout;
+using std::endl;
+using std::vector;
+using std::uint64_t;
+
+
+
+using namespace data_model;
+using namespace data_importing;
+using namespace simulation;
+using namespace benchmark;
+
+
+/// Simulated workload whose performance is guarded.
+struct scenario_t{
+    string difficulty;
+    /// Number of player creatures. Enemy teams grow from it as in the difficulty.
+    int player_count;
+    long long games;
+    uint64_t seed;
+
+    string get_name() const {
+        return difficulty + ", " + std::to_string(player_count) + " player creatures, " + std::to_string(games) + " games";
+    }
+};
+
+struct scenario_result_t{
+    scenario_t scenario;
+    double games_per_second;
+    double p99_turn_ns;
+    double allocations_per_game;
+};
+
+constexpr uint64_t default_seed = 7;
+constexpr double default_threshold = 0.10;
+constexpr int default_repetitions = 5;
+const char* default_scenarios[] { "Hard/6/10000", "Deadly/3/10000", "Easy/2/20000" };
+
+/// Parses scenario written as difficulty/player creatures/games (or throws exception).
+scenario_t parse_scenario(const string& text){
+    std::istringstream i(text);
+    scenario_t result{"", 0, 0, default_seed};
+    string player_count, games;
+    if(!std::getline(i, result.difficulty, '/') || !std::getline(i, player_count, '/') || !std::getline(i, games))
+        throw std::invalid_argument("Scenario " + text + " is not difficulty/player creatures/games.");
+    result.player_count = std::stoi(player_count);
+    result.games = std::stoll(games);
+    return result;
+}
+
+/// Finds difficulty by its name (or throws exception).
+const difficulty_t* find_difficulty(const string& name){
+    for (int i = 0; i < catalog->difficulty_count; ++i) {
+        if(catalog->difficulties[i].name == name) return &catalog->difficulties[i];
+    }
+    throw std::invalid_argument("No difficulty named " + name + ".");
+}
+
+/// Plays the games of the batch again, with the statistics subscribed as in the batch, timing every turn.
+/// @return Latency of the 99th percentile turn in nanoseconds.
+double measure_p99_turn(const scenario_t& scenario, const difficulty_t* difficulty){
+    batch_result_t batch{};
+    game_events_t events;
+    subscribe_statistics(events, batch);
+    rng::context_t random(scenario.seed);
+    vector<float> latencies;
+
+    run_batch(scenario.games, difficulty, random, batch, &events, default_max_turns,
+              [&latencies](logic::game_status_t* game, rng::context_t& random){
+        auto start = std::chrono::steady_clock::now();
+        make_ai_turn(game, random);
+        std::chrono::duration<float, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        latencies.push_back(elapsed.count());
+    });
+
+    if(latencies.empty()) return 0;
+    auto p99 = latencies.begin() + (ptrdiff_t) ((double) (latencies.size() - 1) * 0.99);
+    std::nth_element(latencies.begin(), p99, latencies.end());
+    return *p99;
+}
+
+/// Runs the scenario: throughput is the best of the repetitions, p99 turn latency their median (timed apart, since
+/// reading the clock every turn slows the games), allocations are counted in the first one.
+scenario_result_t run_scenario(const scenario_t& scenario, int repetitions){
+    difficulty_t difficulty = *find_difficulty(scenario.difficulty);
+    difficulty.player_count = scenario.player_count;
+
+    scenario_result_t result{scenario, 0, 0, 0};
+    for (int r = 0; r < repetitions; ++r) {
+        batch_result_t batch{};
+        game_events_t events;
+        subscribe_statistics(events, batch);
+        rng::context_t random(scenario.seed);
+
+        const allocations::report_t allocations_before = allocations::take_report();
+        auto start = std::chrono::steady_clock::now();
+        run_batch(scenario.games, &difficulty, random, batch, &events);
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        if(r == 0){
+            const auto game_allocations = (allocations::take_report() - allocations_before).get_total();
+            result.allocations_per_game = (double) game_allocations.allocations / (double) scenario.games;
+        }
+        result.games_per_second = std::max(result.games_per_second, (double) scenario.games / elapsed.count());
+    }
+
+    vector<double> p99_turns;
+    for (int r = 0; r < std::max(repetitions, 1); ++r) {
+        p99_turns.push_back(measure_p99_turn(scenario, &difficulty));
+    }
+    auto median = p99_turns.begin() + (ptrdiff_t) (p99_turns.size() / 2);
+    std::nth_element(p99_turns.begin(), median, p99_turns.end());
+    result.p99_turn_ns = *median;
+    return result;
+}
+
+void write_results(std::ostream& o, const vector<scenario_result_t>& results){
+    o << "{\n  \"scenarios\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const scenario_result_t& result = results[i];
+        o << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+        write_json_string(o, result.scenario.get_name());
+        o << ", \"difficulty\": ";
+        write_json_string(o, result.scenario.difficulty);
+        o << ", \"player_count\": " << result.scenario.player_count
+          << ", \"games\": " << result.scenario.games
+          << ", \"seed\": " << result.scenario.seed
+          << std::setprecision(10)
+          << ", \"games_per_second\": " << result.games_per_second
+          << ", \"p99_turn_ns\": " << result.p99_turn_ns
+          << ", \"allocations_per_game\": " << result.allocations_per_game << "}";
+    }
+    o << "\n  ]\n}\n";
+}
+
+vector<scenario_result_t> read_results(const string& file_name){
+    std::ifstream i(file_name);
+    if(!i.is_open())
+        throw std::runtime_error("Can not open " + file_name + ".");
+    std::stringstream content;
+    content << i.rdbuf();
+
+    json_value_t root = parse_json(content.str());
+    auto scenarios = root.find("scenarios");
+    if(scenarios == nullptr || scenarios->kind != json_value_t::kind_t::array)
+        throw std::invalid_argument(file_name + " has no scenarios.");
+
+    vector<scenario_result_t> results;
+    for (const auto& item : scenarios->items) {
+        scenario_t scenario{item.get_text("difficulty"), (int) item.get_number("player_count"),
+                            (long long) item.get_number("games"), (uint64_t) item.get_number("seed")};
+        results.push_back({scenario, item.get_number("games_per_second"),
+                           item.get_number("p99_turn_ns"), item.get_number("allocations_per_game")});
+    }
+    return results;
+}
+
+/// Prints one compared metric.
+/// @return True when the metric regressed beyond the threshold.
+bool report_metric(const string& metric, double baseline, double current, bool higher_is_better, double threshold){
+    const double change = baseline != 0 ? (current - baseline) / baseline : (current == 0 ? 0 : 1);
+    const bool regressed = higher_is_better ? change < -threshold : change > threshold;
+
+    cout << "  " << std::left << std::setw(22) << metric << std::right << std::fixed << std::setprecision(1)
+         << std::setw(14) << baseline << std::setw(14) << current
+         << std::setw(9) << std::showpos << change * 100 << std::noshowpos << "%  "
+         << (regressed ? "REGRESSION" : "ok") << endl;
+    return regressed;
+}
+
+int record(const string& file_name, const vector<string>& scenario_texts, int repetitions){
+    vector<scenario_result_t> results;
+    for (const auto& text : scenario_texts) {
+        scenario_t scenario = parse_scenario(text);
+        cout << "Running " << scenario.get_name() << "..." << endl;
+        results.push_back(run_scenario(scenario, repetitions));
+    }
+
+    std::ofstream o(file_name);
+    if(!o.is_open())
+        throw std::runtime_error("Can not write " + file_name + ".");
+    write_results(o, results);
+    cout << "Baseline written to " << file_name << "." << endl;
+    return 0;
+}
+
+int check(const string& file_name, double threshold, int repetitions){
+    int regressions = 0;
+    for (const auto& baseline : read_results(file_name)) {
+        scenario_result_t current = run_scenario(baseline.scenario, repetitions);
+
+        cout << baseline.scenario.get_name() << endl;
+        cout << "  " << std::left << std::setw(22) << "metric" << std::right
+             << std::setw(14) << "baseline" << std::setw(14) << "current" << std::setw(10) << "change" << endl;
+        regressions += report_metric("games/s", baseline.games_per_second, current.games_per_second, true, threshold);
+        regressions += report_metric("p99 turn [ns]", baseline.p99_turn_ns, current.p99_turn_ns, false, threshold);
+        regressions += report_metric("allocations/game", baseline.allocations_per_game, current.allocations_per_game, false, threshold);
+    }
+
+    cout << endl << (regressions == 0 ? "No regression" : std::to_string(regressions) + " regression(s)")
+         << " beyond " << std::setprecision(0) << threshold * 100 << "%." << endl;
+    return regressions == 0 ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    const string command = argc > 1 ? argv[1] : "";
+    const string file_name = argc > 2 ? argv[2] : "bench_baseline.json";
+
+    try{
+        init_module_importing_data_from_files();
+
+        if(command == "record"){
+            vector<string> scenario_texts(argv + std::min(argc, 3), argv + argc);
+            if(scenario_texts.empty()) scenario_texts.assign(std::begin(default_scenarios), std::end(default_scenarios));
+            return record(file_name, scenario_texts, default_repetitions);
+        }
+        if(command == "check"){
+            const double threshold = argc > 3 ? std::stod(argv[3]) : default_threshold;
+            const int repetitions = argc > 4 ? std::stoi(argv[4]) : default_repetitions;
+            return check(file_name, threshold, repetitions);
+        }
+    }
+    catch (const std::exception& e) {
+        cout << e.what() << endl;
+        return 2;
+    }
+
+    cout << "Usage:" << endl
+         << "  record [baseline.json] [difficulty/player creatures/games ...]" << endl
+         << "  check [baseline.json] [threshold, e.g. 0.1] [repetitions]" << endl
+         << "Fails (exit code 1) when games/s drops or p99 turn latency or allocations/game grow beyond the threshold." << endl;
+    return 2;
+}
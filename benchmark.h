@@ -0,0 +1,224 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <algorithm>
+#include <utility>
+#include <cstdlib>
+#include <cctype>
+#include <stdexcept>
+
+using std::string;
+using std::vector;
+
+
+
+namespace benchmark{
+    /// Measurement of one benchmark.
+    struct result_t{
+        string name;
+        long long iterations;
+        double seconds;
+
+        double get_ns_per_op() const { return iterations > 0 ? seconds * 1e9 / (double) iterations : 0; }
+        double get_ops_per_second() const { return seconds > 0 ? (double) iterations / seconds : 0; }
+    };
+
+    /// Byte mixed with results of measured operations, so the compiler can not drop their computation.
+    volatile unsigned char sink = 0;
+
+    /// Keeps the value observable.
+    /// @param value Result of a measured operation.
+    template<class t>
+    void keep(const t& value){
+        sink = sink ^ *reinterpret_cast<const volatile unsigned char*>(&value);
+    }
+
+    /// Iterations after which a benchmark stops even if it has not run for the minimum time.
+    constexpr long long max_iterations = 1LL << 40;
+
+    /// Runs the operation in growing batches until a single batch lasts at least the minimum time.
+    /// @param name Name of the benchmark.
+    /// @param min_seconds Minimum duration of the measured batch.
+    /// @param operation Measured operation, called without arguments.
+    /// @return Measurement of the last batch.
+    template<class operation_t>
+    result_t measure(const string& name, double min_seconds, operation_t&& operation){
+        long long iterations = 1;
+        while (true){
+            auto start = std::chrono::steady_clock::now();
+            for (long long i = 0; i < iterations; ++i) {
+                operation();
+            }
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+            if(elapsed.count() >= min_seconds || iterations >= max_iterations)
+                return {name, iterations, elapsed.count()};
+
+            // Aims slightly past the minimum, growing at most tenfold per batch.
+            const double scale = elapsed.count() > 0 ? std::min(min_seconds * 1.2 / elapsed.count(), 10.0) : 10.0;
+            iterations = std::max(iterations + 1, (long long) ((double) iterations * scale));
+        }
+    }
+
+    void write_json_string(std::ostream& o, const string& value){
+        o << '"';
+        for (char c : value) {
+            if(c == '"' || c == '\\') o << '\\';
+            o << c;
+        }
+        o << '"';
+    }
+
+    /// Writes the results as JSON: {"benchmarks": [{"name", "iterations", "seconds", "ns_per_op", "ops_per_second"}]}.
+    /// @param o Output stream.
+    /// @param results Written results.
+    void write_json(std::ostream& o, const vector<result_t>& results){
+        o << "{\n  \"benchmarks\": [";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const result_t& result = results[i];
+            o << (i == 0 ? "\n" : ",\n") << "    {\"name\": ";
+            write_json_string(o, result.name);
+            o << ", \"iterations\": " << result.iterations
+              << ", \"seconds\": " << result.seconds
+              << ", \"ns_per_op\": " << result.get_ns_per_op()
+              << ", \"ops_per_second\": " << result.get_ops_per_second() << "}";
+        }
+        o << "\n  ]\n}\n";
+    }
+
+    /// Parsed JSON value. Only what result files need: objects keep their members in order.
+    struct json_value_t{
+        enum class kind_t{ null, boolean, number, text, array, object };
+
+        kind_t kind = kind_t::null;
+        bool boolean = false;
+        double number = 0;
+        string text;
+        vector<json_value_t> items;
+        vector<std::pair<string, json_value_t>> members;
+
+        /// @return Member of the object (or null when missing).
+        const json_value_t* find(const string& key) const {
+            for (const auto& member : members) {
+                if(member.first == key) return &member.second;
+            }
+            return nullptr;
+        }
+
+        /// @return Number held by the member (or throws exception when missing).
+        double get_number(const string& key) const {
+            auto member = find(key);
+            if(member == nullptr || member->kind != kind_t::number)
+                throw std::invalid_argument("Missing number " + key + ".");
+            return member->number;
+        }
+
+        /// @return Text held by the member (or throws exception when missing).
+        const string& get_text(const string& key) const {
+            auto member = find(key);
+            if(member == nullptr || member->kind != kind_t::text)
+                throw std::invalid_argument("Missing text " + key + ".");
+            return member->text;
+        }
+    };
+
+    namespace internal{
+        class json_reader_t{
+        private:
+            const string& m_source;
+            size_t m_position = 0;
+
+            void skip_whitespace(){
+                while (m_position < m_source.size() && std::isspace((unsigned char) m_source[m_position])) m_position++;
+            }
+
+            char peek(){
+                skip_whitespace();
+                if(m_position >= m_source.size()) throw std::invalid_argument("Unexpected end of JSON.");
+                return m_source[m_position];
+            }
+
+            void expect(char c){
+                if(peek() != c) throw std::invalid_argument(string("Expected '") + c + "' in JSON.");
+                m_position++;
+            }
+
+            bool try_consume(const char* word){
+                size_t length = std::char_traits<char>::length(word);
+                if(m_source.compare(m_position, length, word) != 0) return false;
+                m_position += length;
+                return true;
+            }
+
+            string read_string(){
+                expect('"');
+                string result;
+                while (m_position < m_source.size() && m_source[m_position] != '"'){
+                    char c = m_source[m_position++];
+                    if(c == '\\' && m_position < m_source.size()){
+                        char escaped = m_source[m_position++];
+                        c = escaped == 'n' ? '\n' : escaped == 't' ? '\t' : escaped;
+                    }
+                    result += c;
+                }
+                expect('"');
+                return result;
+            }
+
+        public:
+            explicit json_reader_t(const string& source) : m_source(source) {}
+
+            json_value_t read_value(){
+                json_value_t result;
+                const char c = peek();
+
+                if(c == '{'){
+                    result.kind = json_value_t::kind_t::object;
+                    m_position++;
+                    if(peek() == '}'){ m_position++; return result; }
+                    do{
+                        string key = read_string();
+                        expect(':');
+                        result.members.emplace_back(key, read_value());
+                    } while (peek() == ',' && ++m_position);
+                    expect('}');
+                }else if(c == '['){
+                    result.kind = json_value_t::kind_t::array;
+                    m_position++;
+                    if(peek() == ']'){ m_position++; return result; }
+                    do{
+                        result.items.push_back(read_value());
+                    } while (peek() == ',' && ++m_position);
+                    expect(']');
+                }else if(c == '"'){
+                    result.kind = json_value_t::kind_t::text;
+                    result.text = read_string();
+                }else if(try_consume("true")){
+                    result.kind = json_value_t::kind_t::boolean;
+                    result.boolean = true;
+                }else if(try_consume("false")){
+                    result.kind = json_value_t::kind_t::boolean;
+                }else if(try_consume("null")){
+                }else{
+                    const char* begin = m_source.c_str() + m_position;
+                    char* end = nullptr;
+                    result.kind = json_value_t::kind_t::number;
+                    result.number = std::strtod(begin, &end);
+                    if(end == begin) throw std::invalid_argument("Invalid JSON value.");
+                    m_position += end - begin;
+                }
+                return result;
+            }
+        };
+    }
+
+    /// Parses JSON (or throws exception).
+    /// @param source JSON text.
+    /// @return Parsed value.
+    json_value_t parse_json(const string& source){
+        return internal::json_reader_t(source).read_value();
+    }
+}
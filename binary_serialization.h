@@ -0,0 +1,260 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <memory>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include "data_model.h"
+#include "data_importing.h"
+#include "logic.h"
+#include "mapped_file.h"
+
+using std::string;
+using std::vector;
+using std::uint32_t;
+using std::uint64_t;
+
+
+
+namespace logic{
+    namespace serialization{
+        /// Binary save layout (all fields are 32-bit little-endian words):
+        /// header   [magic] [version] [team_c] [creature_c] [enemy_i] [turn_i] [is_player_turn] [checksum]
+        /// team_c x [creature_c] [selection_i]
+        /// crea_c x [creature_id] [level] [hp bits] [exp bits]
+        /// Teams are stored player team first; creatures of all teams follow in the same order.
+        /// Health and experience are stored as exact float bits. Checksum is FNV-1a of all bytes but itself.
+        namespace binary{
+            constexpr uint32_t magic = 0x42334754; // "TG3B"
+            constexpr uint32_t version = 1;
+
+            constexpr size_t header_size = 8 * sizeof(uint32_t);
+            constexpr size_t checksum_offset = 7 * sizeof(uint32_t);
+            constexpr size_t team_record_size = 2 * sizeof(uint32_t);
+            constexpr size_t creature_record_size = 4 * sizeof(uint32_t);
+
+            constexpr uint32_t fnv_offset_basis = 2166136261u;
+            constexpr uint32_t fnv_prime = 16777619u;
+
+            uint32_t read_u32(const unsigned char* bytes){
+                return (uint32_t) bytes[0] | ((uint32_t) bytes[1] << 8) |
+                       ((uint32_t) bytes[2] << 16) | ((uint32_t) bytes[3] << 24);
+            }
+
+            int read_i32(const unsigned char* bytes){
+                return (int) read_u32(bytes);
+            }
+
+            float read_f32(const unsigned char* bytes){
+                uint32_t bits = read_u32(bytes);
+                float result;
+                std::memcpy(&result, &bits, sizeof(result));
+                return result;
+            }
+
+            void write_u32(unsigned char* bytes, uint32_t value){
+                bytes[0] = (unsigned char) value;
+                bytes[1] = (unsigned char) (value >> 8);
+                bytes[2] = (unsigned char) (value >> 16);
+                bytes[3] = (unsigned char) (value >> 24);
+            }
+
+            void write_f32(unsigned char* bytes, float value){
+                uint32_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                write_u32(bytes, bits);
+            }
+
+            /// Computes checksum of the save, skipping the checksum field itself.
+            /// @param data First byte of the save.
+            /// @param size Size of the save in bytes.
+            /// @return FNV-1a hash.
+            uint32_t compute_checksum(const unsigned char* data, size_t size){
+                uint32_t hash = fnv_offset_basis;
+                for (size_t i = 0; i < size; ++i) {
+                    if(i >= checksum_offset && i < checksum_offset + sizeof(uint32_t)) continue;
+                    hash = (hash ^ data[i]) * fnv_prime;
+                }
+                return hash;
+            }
+        }
+
+        /// Encodes the game into the binary save layout.
+        /// @param game_status Saved game.
+        /// @return Bytes of the save.
+        vector<unsigned char> encode_game_binary(game_status_i* game_status){
+            const int team_count = (int) game_status->get_enemy_teams_count() + 1;
+
+            int creature_count = 0;
+            for (int t = 0; t < team_count; ++t) {
+                auto team = t == 0 ? game_status->get_player_team() : game_status->get_enemy_team(t - 1);
+                creature_count += (int) team->get_creature_count();
+            }
+
+            vector<unsigned char> result(
+                    binary::header_size +
+                    team_count * binary::team_record_size +
+                    creature_count * binary::creature_record_size);
+
+            unsigned char* header = result.data();
+            binary::write_u32(header, binary::magic);
+            binary::write_u32(header + 4, binary::version);
+            binary::write_u32(header + 8, team_count);
+            binary::write_u32(header + 12, creature_count);
+            binary::write_u32(header + 16, game_status->get_current_enemy_index());
+            binary::write_u32(header + 20, game_status->get_turn_index());
+            binary::write_u32(header + 24, game_status->is_player_turn() ? 1 : 0);
+
+            unsigned char* team_record = header + binary::header_size;
+            unsigned char* creature_record = team_record + team_count * binary::team_record_size;
+
+            for (int t = 0; t < team_count; ++t) {
+                auto team = t == 0 ? game_status->get_player_team() : game_status->get_enemy_team(t - 1);
+                binary::write_u32(team_record, (uint32_t) team->get_creature_count());
+                binary::write_u32(team_record + 4, team->get_selected_creature_index());
+                team_record += binary::team_record_size;
+
+                for (int c = 0; c < (int) team->get_creature_count(); ++c) {
+                    auto creature = team->get_creature(c);
+                    binary::write_u32(creature_record, creature->get_creature()->id);
+                    binary::write_u32(creature_record + 4, creature->get_evolution()->level);
+                    binary::write_f32(creature_record + 8, creature->get_health());
+                    binary::write_f32(creature_record + 12, creature->get_exp());
+                    creature_record += binary::creature_record_size;
+                }
+            }
+
+            binary::write_u32(header + binary::checksum_offset, binary::compute_checksum(result.data(), result.size()));
+            return result;
+        }
+
+        /// Restores the game directly from bytes of a binary save (or throws exception for malformed save).
+        /// @param data First byte of the save. (Not disposed, not kept.)
+        /// @param size Size of the save in bytes.
+        /// @param random Random stream driving the game. (Not disposed.)
+        /// @param events Sinks of the game events. (Not disposed.)
+        /// @return Restored game.
+        game_status_i* decode_game_binary(const unsigned char* data, size_t size,
+                                          rng::context_t* random, game_events_t* events = nullptr){
+            if(data == nullptr || size < binary::header_size)
+                throw std::runtime_error("Binary save is truncated.");
+            if(binary::read_u32(data) != binary::magic)
+                throw std::runtime_error("Not a binary save.");
+            if(binary::read_u32(data + 4) != binary::version)
+                throw std::runtime_error("Unsupported binary save version.");
+
+            const uint32_t team_count = binary::read_u32(data + 8);
+            const uint32_t creature_count = binary::read_u32(data + 12);
+            const uint64_t expected_size =
+                    binary::header_size +
+                    (uint64_t) team_count * binary::team_record_size +
+                    (uint64_t) creature_count * binary::creature_record_size;
+
+            if(team_count < 2 || size != expected_size)
+                throw std::runtime_error("Binary save has invalid size.");
+            if(binary::read_u32(data + binary::checksum_offset) != binary::compute_checksum(data, size))
+                throw std::runtime_error("Binary save checksum mismatch.");
+
+            const int current_enemy_index = binary::read_i32(data + 16);
+            const int turn_index = binary::read_i32(data + 20);
+            const bool is_player_turn = binary::read_u32(data + 24) == 1;
+
+            // Teams index their creatures without bounds checks, so every index is checked before the game is built.
+            if(current_enemy_index < 0 || current_enemy_index >= (int) team_count - 1)
+                throw std::runtime_error("Binary save has invalid current enemy index.");
+            if(turn_index < 0)
+                throw std::runtime_error("Binary save has invalid turn index.");
+
+            const unsigned char* team_record = data + binary::header_size;
+            const unsigned char* creature_record = team_record + team_count * binary::team_record_size;
+
+            uint64_t declared_creatures = 0;
+            for (uint32_t t = 0; t < team_count; ++t) {
+                const unsigned char* record = team_record + t * binary::team_record_size;
+                const uint32_t team_size = binary::read_u32(record);
+                const int selection_index = binary::read_i32(record + 4);
+                if(team_size == 0 || team_size > creature_count)
+                    throw std::runtime_error("Binary save has invalid team size.");
+                if(selection_index < 0 || selection_index >= (int) team_size)
+                    throw std::runtime_error("Binary save has invalid selection index.");
+                declared_creatures += team_size;
+            }
+            if(declared_creatures != creature_count)
+                throw std::runtime_error("Binary save team sizes do not match creature count.");
+
+            std::unique_ptr<game_status_t> result(new game_status_t(
+                    is_player_turn, turn_index, current_enemy_index,
+                    (int) team_count, (int) creature_count, random, events));
+
+            for (uint32_t t = 0; t < team_count; ++t) {
+                const int team_size = binary::read_i32(team_record);
+                auto team = result->append_team(binary::read_i32(team_record + 4));
+                team_record += binary::team_record_size;
+
+                for (int c = 0; c < team_size; ++c) {
+                    int evolution_index = find_evolution_index_by_ids(
+                            binary::read_i32(creature_record),
+                            binary::read_i32(creature_record + 4));
+
+                    const float health = binary::read_f32(creature_record + 8);
+                    const float exp = binary::read_f32(creature_record + 12);
+                    if(!std::isfinite(health) || !std::isfinite(exp) || health < 0 || exp < 0)
+                        throw std::runtime_error("Binary save has invalid creature state.");
+
+                    result->append_creature(team, evolution_index, health, exp);
+                    creature_record += binary::creature_record_size;
+                }
+            }
+
+            return result.release();
+        }
+
+        /// Opens binary save by mapping it into memory.
+        /// @param save_name Name of the save.
+        /// @param random Random stream driving the game. (Not disposed.)
+        /// @param events Sinks of the game events. (Not disposed.)
+        /// @return Restored game.
+        game_status_i* open_game_binary(const string& save_name, rng::context_t* random, game_events_t* events = nullptr){
+            metrics::scoped_timer_t timer(metrics::timer::open);
+            tracing::span_t span("open_game_binary");
+            allocations::scope_t scope(allocations::subsystem::serialization);
+            const string full_path = "Saves/" + save_name + ".bin";
+
+            memory::mapped_file_t file(full_path);
+            return decode_game_binary(file.get_data(), file.get_size(), random, events);
+        }
+
+        /// Saves the game in the binary format (or throws exception when the file can not be written).
+        /// @param save_name Name of the save.
+        /// @param game_status Saved game.
+        void save_game_binary(const string& save_name, game_status_i* game_status){
+            metrics::scoped_timer_t timer(metrics::timer::save);
+            tracing::span_t span("save_game_binary");
+            allocations::scope_t scope(allocations::subsystem::serialization);
+            const string full_path = "Saves/" + save_name + ".bin";
+
+            auto bytes = encode_game_binary(game_status);
+
+            std::ofstream o(full_path, std::ios::binary);
+            if(!o.is_open())
+                throw std::runtime_error("Can not write " + full_path + ".");
+            o.write((const char*) bytes.data(), (std::streamsize) bytes.size());
+            o.close();
+            if(!o)
+                throw std::runtime_error("Can not write " + full_path + ".");
+        }
+
+        /// Checks if there is a binary save of given name.
+        /// @param save_name Name of the save.
+        /// @return True if the binary save exists.
+        bool exists_game_binary(const string& save_name){
+            std::ifstream i("Saves/" + save_name + ".bin", std::ios::binary);
+            return i.is_open();
+        }
+    }
+}
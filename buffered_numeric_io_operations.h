@@ -0,0 +1,40 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::ifstream;
+using std::vector;
+
+
+
+namespace buffered_numeric_io_operations{
+    /// Buffers entire file containing a list of numbers.
+    /// @param file_name Full path to the file.
+    /// @return Buffered numbers (empty when the file can not be opened).
+    vector<int> read_buffered_numbers_file(const string& file_name){
+        ifstream i2(file_name);
+        vector<int> result;
+
+        // Stops at the end, at the first malformed number, or at once when the file can not be opened.
+        int s;
+        while (i2 >> s)
+        {
+            result.push_back(s);
+        }
+
+        i2.close();
+        return result;
+    }
+
+    // void write_buffered_numbers_file(const string& file_name, const vector<int>& values){
+    //     ofstream o2(file_name);
+    //     for (int i : values) {
+    //         o2 << i;
+    //         o2 << ' ';
+    //     }
+    //     o2.close();
+    // }
+}
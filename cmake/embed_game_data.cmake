@@ -0,0 +1,56 @@
+# Converts game data files into C++ initializer rows of constexpr tables.
+# Usage: cmake -DDATA_DIR=<dir with data files> -DOUTPUT=<generated file> -P embed_game_data.cmake
+
+cmake_minimum_required(VERSION 3.20)
+
+# Appends rows of given data file to the generated content.
+# ROW_FORMAT lists kind of every field: "s" for text, "n" for number.
+function(embed_table FILE_NAME TABLE_TYPE TABLE_NAME ROW_FORMAT)
+    file(STRINGS "${DATA_DIR}/${FILE_NAME}" LINES)
+    list(LENGTH ROW_FORMAT FIELD_COUNT)
+
+    set(RESULT "constexpr ${TABLE_TYPE} ${TABLE_NAME}[] {\n")
+    set(LINE_NUMBER 0)
+    foreach(LINE IN LISTS LINES)
+        math(EXPR LINE_NUMBER "${LINE_NUMBER} + 1")
+        string(REGEX MATCHALL "[^ \t\r]+" FIELDS "${LINE}")
+        list(LENGTH FIELDS COUNT)
+        if(COUNT EQUAL 0)
+            continue()
+        endif()
+        if(NOT COUNT EQUAL FIELD_COUNT)
+            message(FATAL_ERROR "${FILE_NAME}:${LINE_NUMBER}: expected ${FIELD_COUNT} fields, found ${COUNT}.")
+        endif()
+
+        set(ROW "")
+        foreach(I RANGE 1 ${FIELD_COUNT})
+            math(EXPR INDEX "${I} - 1")
+            list(GET FIELDS ${INDEX} FIELD)
+            list(GET ROW_FORMAT ${INDEX} KIND)
+            if(KIND STREQUAL "s")
+                set(FIELD "\"${FIELD}\"")
+            elseif(NOT FIELD MATCHES "^[-+]?[0-9]*\\.?[0-9]+$")
+                message(FATAL_ERROR "${FILE_NAME}:${LINE_NUMBER}: field ${I} is not a number.")
+            endif()
+            if(ROW STREQUAL "")
+                set(ROW "${FIELD}")
+            else()
+                set(ROW "${ROW}, ${FIELD}")
+            endif()
+        endforeach()
+        string(APPEND RESULT "    {${ROW}},\n")
+    endforeach()
+    string(APPEND RESULT "};\n\n")
+
+    set(CONTENT "${CONTENT}${RESULT}" PARENT_SCOPE)
+endfunction()
+
+set(CONTENT "// Generated from ${DATA_DIR} by cmake/embed_game_data.cmake. Do not edit.\n\n")
+embed_table("Difficulties.txt" "difficulty_row_t" "difficulty_rows" "s;n;n;n;n")
+embed_table("Creatures.txt" "creature_row_t" "creature_rows" "n;s;s")
+embed_table("Evolutions.txt" "evolution_row_t" "evolution_rows" "n;n;n;n;n;n;n;n;n;s")
+
+# Rewriting unchanged content would trigger needless rebuilds.
+file(WRITE "${OUTPUT}.tmp" "${CONTENT}")
+file(COPY_FILE "${OUTPUT}.tmp" "${OUTPUT}" ONLY_IF_DIFFERENT)
+file(REMOVE "${OUTPUT}.tmp")
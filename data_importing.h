@@ -0,0 +1,658 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <algorithm>
+#include <utility>
+#include <stdexcept>
+#include <charconv>
+#include <iterator>
+
+#include "rng.h"
+#include "data_model.h"
+#include "metrics.h"
+#include "tracing.h"
+#include "allocations.h"
+
+using std::string;
+using std::vector;
+
+
+
+namespace data_importing{
+    using namespace data_model;
+
+    const catalog_t* catalog;
+
+    const char* difficulties_file_name = "Difficulties.txt";
+    const char* evolutions_file_name = "Evolutions.txt";
+    const char* creatures_file_name = "Creatures.txt";
+    const char* element_interactions_file_name = "ElementInteractions.txt";
+    constexpr float element_interaction_damage_mul_buff = 1.5f;
+    constexpr float element_interaction_damage_mul_nerf = 1.0f / element_interaction_damage_mul_buff;
+
+    /// Names of the elements, followed by the name of none. Real elements are indexed by their value.
+    constexpr const char* element_names[] {
+            "Water", "Earth", "Air",
+            "Fire",  "Ice",   "Metal",
+            "None"
+    };
+    /// Number of real elements (all but none), which come first in element_names.
+    constexpr int real_element_count = 6;
+
+    /// Distinguishes the element by its name (or none).
+    /// @param name Literal name of the element.
+    /// @return Result element or none (also for "None").
+    constexpr element get_element_by_name(string_view name) {
+        for (int index = 0; index < real_element_count; ++index) {
+            if(name == element_names[index]) return (element) index;
+        }
+        return element::none;
+    }
+
+    /// Number of rows (and columns) of the element interaction table. Indexed directly by the element value.
+    constexpr int element_table_size = (int) element::none + 1;
+
+    using element_damage_muls_t = std::array<std::array<float, element_table_size>, element_table_size>;
+
+    /// Interactions between elements altering damage. All other pairs deal unaltered damage.
+    constexpr element_interaction_i default_element_interactions[] {
+        {element::water, element::water, element_interaction_damage_mul_nerf },
+        {element::water, element::earth, element_interaction_damage_mul_buff },
+        {element::water, element::fire, element_interaction_damage_mul_buff },
+
+        {element::earth, element::air, element_interaction_damage_mul_nerf },
+        {element::earth, element::fire, element_interaction_damage_mul_buff },
+        {element::earth, element::ice, element_interaction_damage_mul_buff },
+        {element::earth, element::metal, element_interaction_damage_mul_buff},
+
+        {element::air, element::earth, element_interaction_damage_mul_nerf },
+        {element::air, element::ice, element_interaction_damage_mul_buff },
+        {element::air, element::metal, element_interaction_damage_mul_buff },
+
+        {element::fire, element::water, element_interaction_damage_mul_nerf },
+        {element::fire, element::earth, element_interaction_damage_mul_buff },
+        {element::fire, element::ice, element_interaction_damage_mul_buff },
+        {element::fire, element::metal, element_interaction_damage_mul_nerf },
+
+        {element::ice, element::water, element_interaction_damage_mul_nerf },
+        {element::ice, element::earth, element_interaction_damage_mul_buff },
+        {element::ice, element::fire, element_interaction_damage_mul_nerf },
+        {element::ice, element::ice, element_interaction_damage_mul_nerf },
+
+        {element::metal, element::water, element_interaction_damage_mul_buff },
+        {element::metal, element::air, element_interaction_damage_mul_buff },
+        {element::metal, element::fire, element_interaction_damage_mul_nerf },
+        {element::metal, element::metal, element_interaction_damage_mul_nerf },
+    };
+
+    /// Builds dense table of damage muls from the list of interactions.
+    /// @return Damage mul. for every pair of elements (1 for no interaction).
+    constexpr element_damage_muls_t build_element_damage_muls(){
+        element_damage_muls_t result{};
+        for (auto& row : result) {
+            for (auto& mul : row) {
+                mul = 1.0f;
+            }
+        }
+        for (const auto& interaction : default_element_interactions) {
+            result[(int) interaction.attacker][(int) interaction.target] = interaction.multiplier;
+        }
+        return result;
+    }
+
+    constexpr element_damage_muls_t default_element_damage_muls = build_element_damage_muls();
+
+    /// Damage muls. in use. Starts with the built-in table and may be overridden by the data file.
+    element_damage_muls_t element_damage_muls = default_element_damage_muls;
+
+    /// Owns contiguous storage of difficulties, creatures, evolutions and their interned names, exposed as catalog_t.
+    class catalog_storage_t{
+    private:
+        using name_ref_t = std::pair<size_t, size_t>;
+
+        vector<difficulty_t> m_difficulties;
+        vector<name_ref_t> m_difficulty_names;
+        vector<creature_meta_t> m_creatures;
+        vector<evolution_meta_t> m_evolutions;
+        vector<name_ref_t> m_creature_names;
+        vector<name_ref_t> m_evolution_names;
+        vector<int> m_creature_indices_by_id;
+
+        string m_names;
+        std::unordered_map<string, size_t> m_name_offsets;
+
+        catalog_t m_catalog{};
+
+        /// Stores the name once, no matter how many records use it.
+        /// @param name Name of a record.
+        /// @return Offset and length of the name in the pool.
+        name_ref_t intern(string_view name){
+            string key(name);
+            auto existing = m_name_offsets.find(key);
+            if(existing != m_name_offsets.end())
+                return {existing->second, name.size()};
+
+            size_t offset = m_names.size();
+            m_names += key;
+            m_name_offsets.emplace(std::move(key), offset);
+            return {offset, name.size()};
+        }
+
+        string_view view_name(name_ref_t name_ref) const {
+            return string_view(m_names.data() + name_ref.first, name_ref.second);
+        }
+
+    public:
+        catalog_storage_t() = default;
+        catalog_storage_t(const catalog_storage_t&) = delete;
+        catalog_storage_t& operator=(const catalog_storage_t&) = delete;
+
+        /// Adds difficulty record.
+        /// @param difficulty Attributes of the difficulty.
+        /// @param name Name of the difficulty.
+        void add_difficulty(const difficulty_t& difficulty, string_view name){
+            m_difficulties.push_back(difficulty);
+            m_difficulty_names.push_back(intern(name));
+        }
+
+        /// Adds creature record.
+        /// @param id ID of the creature.
+        /// @param name Name of the creature.
+        /// @param element Element of the creature.
+        void add_creature(int id, string_view name, element element){
+            m_creatures.push_back({id, {}, element, no_evolution, 0});
+            m_creature_names.push_back(intern(name));
+        }
+
+        /// Adds evolution record. Its catalog links are resolved by seal.
+        /// @param evolution Attributes of the evolution.
+        /// @param name Name of the evolution.
+        void add_evolution(const evolution_meta_t& evolution, string_view name){
+            m_evolutions.push_back(evolution);
+            m_evolution_names.push_back(intern(name));
+        }
+
+        /// Indexes all added records and links evolutions in linear time (or throws exception).
+        /// Must be called once, after all records were added.
+        /// @return Catalog of the stored records. (Owned by the storage.)
+        const catalog_t* seal(){
+            for (int d = 0; d < (int) m_difficulties.size(); ++d) {
+                m_difficulties[d].name = view_name(m_difficulty_names[d]);
+            }
+
+            int creature_id_limit = 0;
+            for (const auto& creature : m_creatures) {
+                if(creature.id < 0) throw std::invalid_argument("Negative creature id.");
+                creature_id_limit = std::max(creature_id_limit, creature.id + 1);
+            }
+
+            m_creature_indices_by_id.assign(creature_id_limit, -1);
+            for (int c = 0; c < (int) m_creatures.size(); ++c) {
+                int& slot = m_creature_indices_by_id[m_creatures[c].id];
+                if(slot != -1) throw std::invalid_argument("Duplicate creature id.");
+                slot = c;
+                m_creatures[c].name = view_name(m_creature_names[c]);
+            }
+
+            // Evolutions of a creature occupy consecutive slots ordered by level, so each one is placed directly.
+            for (auto& evolution : m_evolutions) {
+                if(evolution.creature_id < 0 || evolution.creature_id >= creature_id_limit ||
+                   m_creature_indices_by_id[evolution.creature_id] == -1)
+                    throw std::invalid_argument("Evolution of unknown creature.");
+                evolution.creature_index = m_creature_indices_by_id[evolution.creature_id];
+                m_creatures[evolution.creature_index].evolution_count++;
+            }
+
+            int first_evolution = 0;
+            for (auto& creature : m_creatures) {
+                creature.first_evolution = creature.evolution_count > 0 ? first_evolution : no_evolution;
+                first_evolution += creature.evolution_count;
+            }
+
+            vector<evolution_meta_t> placed(m_evolutions.size());
+            vector<bool> is_placed(m_evolutions.size(), false);
+            for (int e = 0; e < (int) m_evolutions.size(); ++e) {
+                evolution_meta_t evolution = m_evolutions[e];
+                const creature_meta_t& creature = m_creatures[evolution.creature_index];
+
+                if(evolution.level < 0 || evolution.level >= creature.evolution_count)
+                    throw std::invalid_argument("Evolution levels of a creature must be unique and start at 0.");
+
+                int slot = creature.first_evolution + evolution.level;
+                if(is_placed[slot])
+                    throw std::invalid_argument("Evolution levels of a creature must be unique and start at 0.");
+
+                evolution.name = view_name(m_evolution_names[e]);
+                evolution.next_evolution = evolution.level + 1 < creature.evolution_count ? slot + 1 : no_evolution;
+                placed[slot] = evolution;
+                is_placed[slot] = true;
+            }
+            m_evolutions = std::move(placed);
+
+            m_catalog = {
+                m_difficulties.data(), (int) m_difficulties.size(),
+                m_creatures.data(), (int) m_creatures.size(),
+                m_evolutions.data(), (int) m_evolutions.size(),
+                m_creature_indices_by_id.data(), creature_id_limit,
+            };
+            return &m_catalog;
+        }
+    };
+
+    /// Finds default evolution (level 0) by its creature metadata (or throws exception).
+    /// @param creature_metadata Source creature metadata.
+    /// @return Default evolution metadata.
+    const evolution_meta_t* find_default_evolution_for_creature(const creature_meta_t* creature_metadata) {
+        if(creature_metadata->evolution_count == 0)
+            throw std::exception("Creature has no default evolution.");
+        return &catalog->evolutions[creature_metadata->first_evolution];
+    }
+
+    /// Selects random creature metadata.
+    /// @param random Random stream of the caller.
+    /// @return Random creature metadata.
+    const creature_meta_t* find_random_creature_metadata(rng::context_t& random){
+        auto random_creature_metadata_index = random.next_index(catalog->creature_count);
+        return &catalog->creatures[random_creature_metadata_index];
+    }
+
+    /// Finds creature metadata by its id (or throws exception).
+    /// @param creature_id ID of a creature metadata.
+    /// @return Pointer to the creature metadata.
+    const creature_meta_t* find_creature_metadata_by_ids(int creature_id){
+        int creature_index = catalog->find_creature_index(creature_id);
+        if(creature_index < 0)
+            throw std::exception("No creature with such id.");
+        return &catalog->creatures[creature_index];
+    }
+
+    /// Finds catalog index of evolution by its id and level (or throws exception).
+    /// @param creature_id ID of a creature metadata.
+    /// @param level Level of the evolution.
+    /// @return Catalog index of the evolution.
+    int find_evolution_index_by_ids(int creature_id, int level){
+        int evolution_index = catalog->find_evolution_index(creature_id, level);
+        if(evolution_index == no_evolution)
+            throw std::exception("No evolution with such id.");
+        return evolution_index;
+    }
+
+    /// Finds evolution metadata by its id and level (or throws exception).
+    /// @param creature_id ID of a creature metadata.
+    /// @param level Level of the evolution.
+    /// @return Pointer to the evolution metadata.
+    const evolution_meta_t* find_evolution_metadata_by_ids(int creature_id, int level){
+        return &catalog->evolutions[find_evolution_index_by_ids(creature_id, level)];
+    }
+
+    /// Searches if there is an interaction between elements altering damage.
+    /// @param attacker Element of the attacker.
+    /// @param target Element of the target.
+    /// @return Damage mul. (1 for no interaction)
+    float find_element_damage_mul(element attacker, element target){
+        return element_damage_muls[(int) attacker][(int) target];
+    }
+
+
+    namespace internal
+    {
+        /// Reads entire data file into one buffer and splits it into rows of whitespace-separated fields.
+        /// Blank lines are skipped. Malformed rows are reported with the file name and line number.
+        class row_reader_t{
+        public:
+            static constexpr int max_fields = 16;
+
+        private:
+            string m_file_name;
+            string m_buffer;
+            const char* m_cursor;
+            const char* m_end;
+            int m_line;
+
+            string_view m_fields[max_fields];
+            int m_field_count;
+
+            static bool is_blank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+        public:
+            /// Buffers the file (or throws exception).
+            /// @param file_name Full path to the file.
+            explicit row_reader_t(const char* file_name) : m_file_name(file_name), m_line(0), m_field_count(0) {
+                std::ifstream i(file_name, std::ios::binary);
+                if(!i.is_open())
+                    throw std::runtime_error(m_file_name + ": can not open the file.");
+
+                i.seekg(0, std::ios::end);
+                m_buffer.resize((size_t) i.tellg());
+                i.seekg(0, std::ios::beg);
+                i.read(m_buffer.data(), (std::streamsize) m_buffer.size());
+                i.close();
+
+                m_cursor = m_buffer.data();
+                m_end = m_buffer.data() + m_buffer.size();
+            }
+
+            /// Moves to the next non-blank row.
+            /// @return False when there are no more rows.
+            bool next_row(){
+                while (m_cursor < m_end){
+                    m_line++;
+                    m_field_count = 0;
+
+                    while (m_cursor < m_end && *m_cursor != '\n'){
+                        while (m_cursor < m_end && is_blank(*m_cursor)) m_cursor++;
+                        if(m_cursor == m_end || *m_cursor == '\n') break;
+
+                        const char* field_begin = m_cursor;
+                        while (m_cursor < m_end && *m_cursor != '\n' && !is_blank(*m_cursor)) m_cursor++;
+
+                        if(m_field_count == max_fields) fail("too many fields");
+                        m_fields[m_field_count++] = string_view(field_begin, m_cursor - field_begin);
+                    }
+                    if(m_cursor < m_end) m_cursor++;
+
+                    if(m_field_count > 0) return true;
+                }
+                return false;
+            }
+
+            /// Throws exception describing the problem with the current row.
+            /// @param reason Description of the problem.
+            [[noreturn]] void fail(const string& reason) const {
+                throw std::runtime_error(m_file_name + ":" + std::to_string(m_line) + ": " + reason + ".");
+            }
+
+            /// Rejects the current row unless it has given number of fields.
+            /// @param count Expected number of fields.
+            void expect_fields(int count) const {
+                if(m_field_count != count)
+                    fail("expected " + std::to_string(count) + " fields, found " + std::to_string(m_field_count));
+            }
+
+            string_view get_text(int field) const { return m_fields[field]; }
+
+            int get_int(int field) const {
+                int result = 0;
+                auto text = m_fields[field];
+                auto parsed = std::from_chars(text.data(), text.data() + text.size(), result);
+                if(parsed.ec != std::errc() || parsed.ptr != text.data() + text.size())
+                    fail("field " + std::to_string(field + 1) + " is not an integer");
+                return result;
+            }
+
+            float get_float(int field) const {
+                float result = 0;
+                auto text = m_fields[field];
+                auto parsed = std::from_chars(text.data(), text.data() + text.size(), result);
+                if(parsed.ec != std::errc() || parsed.ptr != text.data() + text.size())
+                    fail("field " + std::to_string(field + 1) + " is not a number");
+                return result;
+            }
+        };
+
+        /// Reads element of the current row (or throws exception for unknown name).
+        /// @param r Reader of the row.
+        /// @param field Index of the field holding the element name.
+        element get_element_field(const row_reader_t& r, int field){
+            auto name = r.get_text(field);
+            auto result = get_element_by_name(name);
+            if(result == element::none && name != element_names[real_element_count])
+                r.fail("unknown element " + string(name));
+            return result;
+        }
+
+        /// Reads skill type of the current row (or throws exception for unknown id).
+        /// @param r Reader of the row.
+        /// @param field Index of the field holding the skill id.
+        skill_type get_skill_field(const row_reader_t& r, int field){
+            const int id = r.get_int(field);
+            if(id < (int) skill_type::none || id > (int) skill_type::hp_ratio_damage)
+                r.fail("unknown skill " + std::to_string(id));
+            return (skill_type) id;
+        }
+
+        void load_difficulties(catalog_storage_t& storage) {
+            row_reader_t r(difficulties_file_name);
+            while (r.next_row()){
+                r.expect_fields(5);
+                difficulty_t difficulty{};
+                difficulty.out_dmg_mul = r.get_float(1);
+                difficulty.in_dmg_mul = r.get_float(2);
+                difficulty.enemy_count = r.get_int(3);
+                difficulty.player_count = r.get_int(4);
+                storage.add_difficulty(difficulty, r.get_text(0));
+            }
+        }
+
+        void load_creatures(catalog_storage_t& storage) {
+            row_reader_t r(creatures_file_name);
+            while (r.next_row()){
+                r.expect_fields(3);
+                storage.add_creature(r.get_int(0), r.get_text(1), get_element_by_name(r.get_text(2)));
+            }
+        }
+
+        void load_evolutions(catalog_storage_t& storage){
+            row_reader_t r(evolutions_file_name);
+            while (r.next_row()){
+                r.expect_fields(10);
+                evolution_meta_t evolution{};
+
+                evolution.creature_id = r.get_int(0);
+                evolution.level = r.get_int(1);
+
+                evolution.strength = r.get_float(2);
+                evolution.max_health = r.get_float(3);
+                evolution.agility = r.get_float(4);
+
+                evolution.bounty_exp = r.get_float(5);
+                evolution.required_exp = r.get_float(6);
+
+                evolution.skill_type = get_skill_field(r, 7);
+                evolution.skill_power = r.get_float(8);
+
+                storage.add_evolution(evolution, r.get_text(9));
+            }
+        }
+
+
+        /// Overrides built-in element interactions with the optional data file (or throws exception for malformed
+        /// row). Missing file keeps the defaults.
+        void load_element_interactions(){
+            element_damage_muls = default_element_damage_muls;
+
+            if(!std::ifstream(element_interactions_file_name).is_open()) return;
+
+            row_reader_t r(element_interactions_file_name);
+            while (r.next_row()){
+                r.expect_fields(3);
+                auto attacker = get_element_field(r, 0);
+                auto target = get_element_field(r, 1);
+                element_damage_muls[(int) attacker][(int) target] = r.get_float(2);
+            }
+        }
+    }
+    using namespace data_importing::internal;
+
+    /// Default attacks of every ordered pair of evolutions, attacker-major. Built whenever the catalog is loaded.
+    vector<matchup_t> matchups;
+
+    /// Finds outcome of the default attack.
+    /// @param attacker_evolution Catalog index of the attacker evolution.
+    /// @param target_evolution Catalog index of the target evolution.
+    /// @return Matchup of the evolutions.
+    const matchup_t& find_matchup(int attacker_evolution, int target_evolution){
+        return matchups[attacker_evolution * catalog->evolution_count + target_evolution];
+    }
+
+    /// Precomputes matchups of the loaded catalog and element interactions.
+    void build_matchups(){
+        const int evolution_count = catalog->evolution_count;
+        matchups.resize((size_t) evolution_count * evolution_count);
+
+        for (int a = 0; a < evolution_count; ++a) {
+            const evolution_meta_t& attacker = catalog->evolutions[a];
+            for (int t = 0; t < evolution_count; ++t) {
+                const evolution_meta_t& target = catalog->evolutions[t];
+                matchup_t& matchup = matchups[a * evolution_count + t];
+
+                matchup.hit_damage = attacker.strength * find_element_damage_mul(
+                        catalog->creatures[attacker.creature_index].element,
+                        catalog->creatures[target.creature_index].element);
+                matchup.hit_probability = 1 - target.agility / 100.0f;
+                matchup.expected_damage = matchup.hit_damage * matchup.hit_probability;
+                matchup.hits_to_kill = matchup.get_hits_to_kill(target.max_health);
+            }
+        }
+    }
+
+#ifdef TURNS_GAME_EMBEDDED_DATA
+    /// Game metadata compiled into the executable (TURNS_GAME_EMBED_DATA build option).
+    /// Rows are generated from the data files by cmake/embed_game_data.cmake. Catalog links are resolved
+    /// while compiling, the same way catalog_storage_t::seal does it, so malformed data fails the build.
+    namespace embedded{
+        struct creature_row_t{
+            int id;
+            string_view name;
+            string_view element_name;
+        };
+
+        struct evolution_row_t{
+            int creature_id;
+            int level;
+            float strength;
+            float max_health;
+            float agility;
+            float bounty_exp;
+            float required_exp;
+            int skill_type;
+            float skill_power;
+            string_view name;
+        };
+
+        using difficulty_row_t = difficulty_t;
+
+        #include "embedded_game_data.inc"
+
+        constexpr int difficulty_count = (int) std::size(difficulty_rows);
+        constexpr int creature_count = (int) std::size(creature_rows);
+        constexpr int evolution_count = (int) std::size(evolution_rows);
+
+        constexpr int find_creature_id_limit(){
+            int result = 0;
+            for (const auto& row : creature_rows) {
+                if(row.id < 0) throw std::invalid_argument("Negative creature id.");
+                result = std::max(result, row.id + 1);
+            }
+            return result;
+        }
+
+        constexpr int creature_id_limit = find_creature_id_limit();
+
+        struct tables_t{
+            creature_meta_t creatures[creature_count];
+            evolution_meta_t evolutions[evolution_count];
+            int creature_indices_by_id[creature_id_limit];
+        };
+
+        constexpr tables_t build_tables(){
+            tables_t result{};
+            for (int& slot : result.creature_indices_by_id) {
+                slot = -1;
+            }
+
+            for (int c = 0; c < creature_count; ++c) {
+                const creature_row_t& row = creature_rows[c];
+                int& slot = result.creature_indices_by_id[row.id];
+                if(slot != -1) throw std::invalid_argument("Duplicate creature id.");
+                slot = c;
+                result.creatures[c] = {row.id, row.name, get_element_by_name(row.element_name), no_evolution, 0};
+            }
+
+            int creature_indices[evolution_count]{};
+            for (int e = 0; e < evolution_count; ++e) {
+                const int creature_id = evolution_rows[e].creature_id;
+                if(creature_id < 0 || creature_id >= creature_id_limit || result.creature_indices_by_id[creature_id] == -1)
+                    throw std::invalid_argument("Evolution of unknown creature.");
+                creature_indices[e] = result.creature_indices_by_id[creature_id];
+                result.creatures[creature_indices[e]].evolution_count++;
+            }
+
+            int first_evolution = 0;
+            for (auto& creature : result.creatures) {
+                creature.first_evolution = creature.evolution_count > 0 ? first_evolution : no_evolution;
+                first_evolution += creature.evolution_count;
+            }
+
+            bool is_placed[evolution_count]{};
+            for (int e = 0; e < evolution_count; ++e) {
+                const evolution_row_t& row = evolution_rows[e];
+                const creature_meta_t& creature = result.creatures[creature_indices[e]];
+
+                if(row.level < 0 || row.level >= creature.evolution_count)
+                    throw std::invalid_argument("Evolution levels of a creature must be unique and start at 0.");
+
+                int slot = creature.first_evolution + row.level;
+                if(is_placed[slot])
+                    throw std::invalid_argument("Evolution levels of a creature must be unique and start at 0.");
+                if(row.skill_type < (int) data_model::skill_type::none || row.skill_type > (int) data_model::skill_type::hp_ratio_damage)
+                    throw std::invalid_argument("Evolution has unknown skill type.");
+
+                result.evolutions[slot] = {
+                    row.creature_id, row.level, row.name,
+                    row.strength, row.max_health, row.agility,
+                    row.bounty_exp, row.required_exp,
+                    (data_model::skill_type) row.skill_type, row.skill_power,
+                    row.level + 1 < creature.evolution_count ? slot + 1 : no_evolution,
+                    creature_indices[e],
+                };
+                is_placed[slot] = true;
+            }
+            return result;
+        }
+
+        constexpr tables_t tables = build_tables();
+
+        constexpr catalog_t catalog{
+            difficulty_rows, difficulty_count,
+            tables.creatures, creature_count,
+            tables.evolutions, evolution_count,
+            tables.creature_indices_by_id, creature_id_limit,
+        };
+    }
+#endif
+
+    /// Loads game metadata from the data files. Exceptions are not handled.
+    void init_module_importing_data_from_files(){
+        metrics::scoped_timer_t timer(metrics::timer::metadata_load);
+        tracing::span_t span("init_module_importing_data");
+        allocations::scope_t scope(allocations::subsystem::data_importing);
+        auto storage = new catalog_storage_t;
+        load_difficulties(*storage);
+        load_creatures(*storage);
+        load_evolutions(*storage);
+        catalog = storage->seal();
+
+        load_element_interactions();
+        build_matchups();
+    }
+
+    /// Loads game metadata from the embedded tables when the build has them, otherwise from the data files.
+    /// Exceptions are not handled.
+    void init_module_importing_data(){
+#ifdef TURNS_GAME_EMBEDDED_DATA
+        metrics::scoped_timer_t timer(metrics::timer::metadata_load);
+        tracing::span_t span("init_module_importing_data");
+        allocations::scope_t scope(allocations::subsystem::data_importing);
+        catalog = &embedded::catalog;
+        element_damage_muls = default_element_damage_muls;
+        build_matchups();
+#else
+        init_module_importing_data_from_files();
+#endif
+    }
+}
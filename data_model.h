@@ -0,0 +1,254 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <cmath>
+
+using std::string;
+using std::string_view;
+
+
+
+namespace data_model{
+    enum class element{
+        water = 0,   earth = 1,   air = 2,
+        fire = 3,    ice = 4,     metal = 5,
+        none = 7,
+    };
+
+    enum class skill_type{
+        /// No skill
+        none = 0,
+
+        /// Damage applied to all enemy team members.
+        massive_damage = 1,
+
+        /// Attack of value corresponding to max health of the enemy (evolution).
+        max_hp_ratio_damage = 2,
+
+        /// Attack of value corresponding to current (not max) health of the enemy (evolution).
+        hp_ratio_damage = 3,
+    };
+
+    struct difficulty_t{
+        string_view name;
+        float out_dmg_mul;
+        float in_dmg_mul;
+        int enemy_count;
+        int player_count;
+    };
+
+    /// Index of evolution marking there is no further evolution.
+    constexpr int no_evolution = -1;
+
+    struct evolution_meta_t{
+        int creature_id;
+        int level;
+
+        string_view name;
+        float strength;
+        float max_health;
+        float agility;
+        float bounty_exp;
+        float required_exp;
+
+        skill_type skill_type;
+        float skill_power;
+
+        /// Catalog index of the next evolution (or no_evolution).
+        int next_evolution;
+        /// Catalog index of the creature.
+        int creature_index;
+    };
+
+    /// Outcome of the default attack of one evolution on another.
+    struct matchup_t{
+        /// Damage of a hit (strength of the attacker multiplied by the element interaction).
+        float hit_damage;
+        /// Chance that the target does not dodge.
+        float hit_probability;
+        /// Damage per attack, dodges included.
+        float expected_damage;
+        /// Hits killing fully healed target (0 when the attack does no damage).
+        int hits_to_kill;
+
+        /// Counts hits killing the wounded target. Rounding errors below a thousandth of a hit are ignored.
+        /// @param target_health Health of the target.
+        /// @return Number of hits (0 when the attack does no damage).
+        int get_hits_to_kill(float target_health) const {
+            return hit_damage > 0 ? (int) std::ceil(target_health / hit_damage - 0.001f) : 0;
+        }
+    };
+
+    struct creature_meta_t{
+        int id;
+        string_view name;
+        element element;
+
+        /// Catalog index of the default (level 0) evolution. Evolutions of a creature are stored by level.
+        int first_evolution;
+        int evolution_count;
+    };
+
+    /// Immutable view of all difficulties, creatures and evolutions, stored contiguously and indexed by (creature id, level).
+    struct catalog_t{
+        const difficulty_t* difficulties;
+        int difficulty_count;
+
+        const creature_meta_t* creatures;
+        int creature_count;
+
+        const evolution_meta_t* evolutions;
+        int evolution_count;
+
+        /// Catalog index of creature for every id (or -1), indexed by the id.
+        const int* creature_indices_by_id;
+        int creature_id_limit;
+
+        /// Finds index of creature by its id.
+        /// @param creature_id ID of the creature.
+        /// @return Catalog index of the creature or -1.
+        int find_creature_index(int creature_id) const {
+            if(creature_id < 0 || creature_id >= creature_id_limit) return -1;
+            return creature_indices_by_id[creature_id];
+        }
+
+        /// Finds index of evolution by its creature id and level.
+        /// @param creature_id ID of the creature.
+        /// @param level Level of the evolution.
+        /// @return Catalog index of the evolution or no_evolution.
+        int find_evolution_index(int creature_id, int level) const {
+            int creature_index = find_creature_index(creature_id);
+            if(creature_index < 0) return no_evolution;
+
+            const creature_meta_t& creature = creatures[creature_index];
+            if(level < 0 || level >= creature.evolution_count) return no_evolution;
+            return creature.first_evolution + level;
+        }
+    };
+
+    enum class player_action{
+        none = 0,
+        attack = 1,
+        skill_use = 2,
+        creature_reselection = 4,
+        evolution = 8,
+    };
+
+
+    class creature_i{
+    public:
+        virtual float get_health() = 0;
+        virtual float get_exp() = 0;
+        virtual bool is_alive() = 0;
+        virtual const evolution_meta_t* get_evolution() = 0;
+        virtual const creature_meta_t* get_creature() = 0;
+
+        bool can_evolute();
+    };
+
+    class team_i{
+    public:
+        virtual size_t get_creature_count() = 0;
+        virtual creature_i* get_creature(int index) = 0;
+        virtual creature_i* get_selected_creature() = 0;
+        virtual int get_selected_creature_index() = 0;
+        virtual bool is_creature_selectable(int index) = 0;
+        virtual int get_selectable_creature_count();
+
+        virtual bool is_defeated() = 0;
+    };
+
+    int team_i::get_selectable_creature_count() {
+        int result = 0;
+        for (int i = 0; i < get_creature_count(); ++i) {
+            if(get_creature(i)->is_alive()) result++;
+        }
+        return result;
+    }
+
+    class game_status_i{
+    public:
+        virtual int get_turn_index() = 0;
+        virtual bool is_player_turn() = 0;
+        virtual team_i* get_player_team() = 0;
+        virtual size_t get_enemy_teams_count() = 0;
+        virtual team_i* get_enemy_team(int index) = 0;
+        virtual int get_current_enemy_index() = 0;
+
+        virtual bool are_all_enemy_teams_defeated();
+        bool is_round_over();
+        bool is_game_over();
+        team_i* get_current_enemy_team();
+
+        virtual bool can_make_turn_select_any_creature(bool player_team) = 0;
+        virtual bool can_make_turn_select_creature(bool player_team, int selection_index) = 0;
+        virtual bool can_make_turn_evolute(bool player_team) = 0;
+        virtual bool can_make_turn_use_attack(bool player_team) = 0;
+        virtual bool can_make_turn_use_skill(bool player_team) = 0;
+
+        virtual void make_turn_select_creature(bool player_team, int selection_index) = 0;
+        virtual void make_turn_evolute(bool player_team) = 0;
+        virtual void make_turn_use_attack(bool player_team) = 0;
+        virtual void make_turn_use_skill(bool player_team) = 0;
+
+        virtual bool try_make_obligatory_turn(bool player_team) = 0;
+        virtual void swap_turns() = 0;
+        virtual bool try_fight_next_enemy() = 0;
+
+        virtual ~game_status_i() = default;
+    };
+
+
+
+    bool game_status_i::are_all_enemy_teams_defeated() {
+        for (int i = 0; i < get_enemy_teams_count(); ++i) {
+            auto enemy_team = get_enemy_team(i);
+            if(!enemy_team->is_defeated())
+                return false;
+        }
+        return true;
+    }
+
+    bool game_status_i::is_round_over() {
+        bool player_team_defeated = get_player_team()->is_defeated();
+        bool enemy_team_defeated = get_current_enemy_team()->is_defeated();
+        return player_team_defeated || enemy_team_defeated;
+    }
+
+    bool game_status_i::is_game_over() {
+        return get_player_team()->is_defeated() || are_all_enemy_teams_defeated();
+    }
+
+    team_i* game_status_i::get_current_enemy_team() {
+        return get_enemy_team(get_current_enemy_index());
+    }
+
+    bool creature_i::can_evolute() {
+        return
+                this->get_exp() >= this->get_evolution()->required_exp &&
+                this->get_evolution()->next_evolution != no_evolution &&
+                this->is_alive();
+    }
+
+
+
+    struct damage_i{
+        creature_i* attacker;
+        creature_i* target;
+        float value;
+    };
+
+    struct selection_i{
+        int index;
+        creature_i* selected;
+        bool is_player_team;
+    };
+
+
+    struct element_interaction_i{
+        const element attacker;
+        const element target;
+        const float multiplier;
+    };
+}
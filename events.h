@@ -0,0 +1,88 @@
+#pragma once
+
+#include <vector>
+#include <functional>
+#include <memory>
+
+#include "allocations.h"
+
+using std::vector;
+using std::function;
+
+
+
+namespace events{
+    /// Utility class to announce invocation of some one-argument event.
+    /// Listeners known at compile time are called through a single thunk each, with the listener inlined into it;
+    /// other listeners are wrapped in std::function. Invocation without listeners is a single branch.
+    /// @tparam args_t Type of the argument.
+    /// @tparam enabled False compiles the event out: subscriptions are dropped and invocations do nothing.
+    template<class args_t, bool enabled = true>
+    class event{
+    private:
+        using thunk_t = void (*)(void* context, const args_t& args);
+
+        struct listener_t{
+            void* context;
+            thunk_t call;
+        };
+
+        vector<listener_t> listeners;
+        vector<std::unique_ptr<function<void(const args_t&)>>> erased_listeners;
+
+    public:
+        static constexpr bool is_enabled = enabled;
+
+        /// Adds function to invoke list making it a listener.
+        /// @param listener New listener.
+        void subscribe(function<void(const args_t&)> listener){
+            if constexpr (enabled){
+                allocations::scope_t scope(allocations::subsystem::events);
+                erased_listeners.push_back(std::make_unique<function<void(const args_t&)>>(std::move(listener)));
+                listeners.push_back({erased_listeners.back().get(), [](void* context, const args_t& args){
+                    (*static_cast<function<void(const args_t&)>*>(context))(args);
+                }});
+            }
+        }
+
+        /// Adds free function known at compile time as a listener.
+        /// @tparam listener Function called as listener(args).
+        template<auto listener>
+        void subscribe(){
+            if constexpr (enabled){
+                allocations::scope_t scope(allocations::subsystem::events);
+                listeners.push_back({nullptr, [](void*, const args_t& args){ listener(args); }});
+            }
+        }
+
+        /// Adds function known at compile time as a listener bound to some state.
+        /// @tparam listener Function called as listener(*context, args).
+        /// @param context State passed to the listener. (Not disposed, must outlive the event.)
+        template<auto listener, class context_t>
+        void subscribe(context_t* context){
+            if constexpr (enabled){
+                allocations::scope_t scope(allocations::subsystem::events);
+                listeners.push_back({context, [](void* bound, const args_t& args){
+                    listener(*static_cast<context_t*>(bound), args);
+                }});
+            }
+        }
+
+        /// Tells if invocation would reach anyone. Lets callers skip building arguments.
+        /// @return False for events compiled out or without listeners.
+        bool has_listeners() const {
+            if constexpr (enabled) return !listeners.empty();
+            else return false;
+        }
+
+        /// Invokes all listeners.
+        /// @param args Argument passed to all listeners.
+        void invoke(const args_t& args) const {
+            if constexpr (enabled){
+                for (const auto& listener : listeners) {
+                    listener.call(listener.context, args);
+                }
+            }
+        }
+    };
+}
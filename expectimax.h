@@ -0,0 +1,296 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+#include "rng.h"
+#include "data_model.h"
+#include "logic.h"
+#include "packed_encounter.h"
+#include "ai.h"
+#include "tablebase.h"
+
+using std::vector;
+using std::uint32_t;
+using std::uint64_t;
+
+
+
+namespace ai{
+    using namespace data_model;
+    using logic::internal::game_status_t;
+
+    /// Settings of the expectimax bot.
+    struct expectimax_config_t{
+        /// Time after which deepening stops. The deepest completed iteration decides.
+        std::chrono::microseconds time_budget = std::chrono::microseconds(5000);
+        /// Depth (in turns) at which deepening stops even within the time budget.
+        int max_depth = 32;
+        /// Number of entries of the transposition table. Must be a power of two.
+        size_t table_size = size_t(1) << 16;
+    };
+
+    /// Expectimax bot. Sides maximize (player) or minimize (enemy) the player's chance to win the current round;
+    /// the dodge roll of every attack is a chance node. Positions are cached in a fixed-size transposition table
+    /// keyed by Zobrist hashes of packed creatures, updated incrementally from the deltas of the undo stack.
+    /// Positions with one living creature per side are looked up in the endgame tablebase, when one is attached.
+    class expectimax_t{
+    private:
+        struct entry_t{
+            uint64_t key;
+            float value;
+            int depth;
+        };
+
+        /// Thrown through the search when the time budget runs out.
+        struct timeout_t{};
+
+        static constexpr uint64_t player_turn_key = 0x6A09E667F3BCC909ull;
+        static constexpr int nodes_per_clock_check = 1024;
+
+        expectimax_config_t m_config;
+        vector<entry_t> m_table;
+        logic::undo_stack_t m_undo;
+        const tablebase::tablebase_t* m_tablebase = nullptr;
+        /// Moves of every ply, reused between searches.
+        vector<vector<move_t>> m_moves;
+
+        /// Index of the first creature of the current enemy team among all creatures of the game.
+        int m_enemy_first_creature;
+        int m_player_count;
+        std::chrono::steady_clock::time_point m_deadline;
+        int m_nodes;
+
+        /// Pseudo-random key of a feature of the state (creature word in a slot, selection of a team).
+        static uint64_t get_feature_key(uint64_t feature){
+            return rng::next_splitmix64(feature);
+        }
+
+        static uint64_t get_creature_key(int slot, const logic::creature_state_t& state){
+            return get_feature_key(((uint64_t) slot << 32) |
+                logic::packing::pack_creature(state.evolution_index, state.health, state.exp));
+        }
+
+        static uint64_t get_selection_key(int team_index, int selection_index){
+            return get_feature_key((uint64_t(1) << 63) | ((uint64_t) team_index << 16) | (uint64_t) selection_index);
+        }
+
+        /// Slot of the creature in the encounter: player creatures first, then creatures of the current enemy team.
+        int get_slot(int creature_index) const {
+            return creature_index < m_player_count ? creature_index : creature_index - m_enemy_first_creature + m_player_count;
+        }
+
+        uint64_t compute_hash(game_status_t* game){
+            uint64_t result = game->is_player_turn() ? player_turn_key : 0;
+
+            for (int t = 0; t < 2; ++t) {
+                auto team = t == 0 ? game->get_player_team_mutable() : game->get_enemy_team_mutable(game->get_current_enemy_index());
+                result ^= get_selection_key(t == 0 ? 0 : game->get_current_enemy_index() + 1, team->get_selected_creature_index());
+                for (int c = 0; c < (int) team->get_creature_count(); ++c) {
+                    result ^= get_creature_key(t == 0 ? c : m_player_count + c, team->get_creature_mutable(c)->get_state());
+                }
+            }
+            return result;
+        }
+
+        /// Updates hash by changes recorded since given mark. Only the oldest record of a changed feature
+        /// holds its value before the changes, so later records of the same feature are skipped.
+        uint64_t update_hash(uint64_t hash, game_status_t* game, size_t change_mark){
+            const auto& changes = m_undo.changes;
+            const auto& deltas = m_undo.creature_deltas;
+            if(change_mark == changes.size()) return hash;
+
+            if(changes[change_mark].is_player_turn != game->is_player_turn())
+                hash ^= player_turn_key;
+
+            for (size_t i = change_mark; i < changes.size(); ++i) {
+                const int team_index = changes[i].team_index;
+                if(team_index < 0) continue;
+
+                bool is_oldest = true;
+                for (size_t j = change_mark; j < i; ++j) {
+                    if(changes[j].team_index == team_index){ is_oldest = false; break; }
+                }
+                if(!is_oldest) continue;
+
+                auto team = team_index == 0 ? game->get_player_team_mutable() : game->get_enemy_team_mutable(team_index - 1);
+                hash ^= get_selection_key(team_index, changes[i].selection_index) ^
+                        get_selection_key(team_index, team->get_selected_creature_index());
+            }
+
+            const int first_delta = changes[change_mark].first_creature_delta;
+            for (int d = first_delta; d < (int) deltas.size(); ++d) {
+                const int creature_index = deltas[d].creature_index;
+
+                bool is_oldest = true;
+                for (int e = first_delta; e < d; ++e) {
+                    if(deltas[e].creature_index == creature_index){ is_oldest = false; break; }
+                }
+                if(!is_oldest) continue;
+
+                const int slot = get_slot(creature_index);
+                auto creature = slot < m_player_count ?
+                        game->get_player_team_mutable()->get_creature_mutable(slot) :
+                        game->get_enemy_team_mutable(game->get_current_enemy_index())->get_creature_mutable(slot - m_player_count);
+                hash ^= get_creature_key(slot, deltas[d].state) ^ get_creature_key(slot, creature->get_state());
+            }
+            return hash;
+        }
+
+        void undo_to(game_status_t* game, size_t change_mark){
+            while (m_undo.get_change_count() > change_mark){
+                game->undo_last_change();
+            }
+        }
+
+        /// Value of the position after the move, including its swap of turns.
+        float search_move(game_status_t* game, uint64_t hash, int ply, int depth, const move_t& move){
+            const bool player_team = game->is_player_turn();
+            const size_t change_mark = m_undo.get_change_count();
+
+            if(move.action != player_action::attack){
+                apply_move(game, player_team, move);
+                game->swap_turns();
+                float value = search(game, update_hash(hash, game, change_mark), ply + 1, depth - 1);
+                undo_to(game, change_mark);
+                return value;
+            }
+
+            // Chance node: the attack either hits or is dodged.
+            const float dodge_probability = game->get_dodge_probability(player_team);
+            float value = 0;
+            for (int dodged = 0; dodged < 2; ++dodged) {
+                const float probability = dodged ? dodge_probability : 1 - dodge_probability;
+                if(probability <= 0) continue;
+
+                game->make_turn_use_attack(player_team, dodged != 0);
+                game->swap_turns();
+                value += probability * search(game, update_hash(hash, game, change_mark), ply + 1, depth - 1);
+                undo_to(game, change_mark);
+            }
+            return value;
+        }
+
+        float search(game_status_t* game, uint64_t hash, int ply, int depth){
+            if(++m_nodes % nodes_per_clock_check == 0 && std::chrono::steady_clock::now() > m_deadline)
+                throw timeout_t{};
+
+            if(game->is_round_over())
+                return evaluate_round(game);
+
+            if(m_tablebase != nullptr){
+                const float value = m_tablebase->probe(game);
+                if(value >= 0) return game->is_player_turn() ? value : 1 - value;
+            }
+
+            if(depth <= 0)
+                return evaluate_round(game);
+
+            entry_t& entry = m_table[hash & (m_table.size() - 1)];
+            if(entry.key == hash && entry.depth >= depth)
+                return entry.value;
+
+            const bool player_team = game->is_player_turn();
+            const size_t change_mark = m_undo.get_change_count();
+
+            float best;
+            if(game->try_make_obligatory_turn(player_team)){
+                game->swap_turns();
+                best = search(game, update_hash(hash, game, change_mark), ply + 1, depth - 1);
+                undo_to(game, change_mark);
+            }else{
+                if((int) m_moves.size() <= ply) m_moves.resize(ply + 1);
+                list_moves(game, player_team, m_moves[ply]);
+
+                best = player_team ? -1.0f : 2.0f;
+                for (int m = 0; m < (int) m_moves[ply].size(); ++m) {
+                    float value = search_move(game, hash, ply, depth, m_moves[ply][m]);
+                    if(player_team ? value > best : value < best) best = value;
+                }
+            }
+
+            entry = {hash, best, depth};
+            return best;
+        }
+
+    public:
+        /// Creates the bot.
+        /// @param config Settings of the search.
+        explicit expectimax_t(const expectimax_config_t& config = {}) :
+            m_config(config), m_table(config.table_size), m_enemy_first_creature(0), m_player_count(0), m_nodes(0) {
+            if(config.table_size == 0 || (config.table_size & (config.table_size - 1)) != 0)
+                throw std::invalid_argument("Size of the transposition table must be a power of two.");
+        }
+
+        /// Attaches endgame tablebase, which then replaces the search of 1v1 positions.
+        /// @param tablebase Tablebase generated for the loaded catalog, or null to search every position. (Not disposed.)
+        void set_tablebase(const tablebase::tablebase_t* tablebase){ m_tablebase = tablebase; }
+
+        /// Searches for the best move of the side which is to move. Obligatory turns must be made beforehand.
+        /// @param game Contemporary game status. (Not modified.)
+        /// @return Best move of the deepest completed iteration.
+        move_t find_move(game_status_t* game){
+            allocations::scope_t scope(allocations::subsystem::ai);
+            const bool player_team = game->is_player_turn();
+
+            vector<move_t> root_moves;
+            list_moves(game, player_team, root_moves);
+            if(root_moves.empty())
+                throw std::invalid_argument("There is no legal move to search.");
+            if(root_moves.size() == 1)
+                return root_moves[0];
+            // Transposition keys are built from packed creatures.
+            logic::packing::require_packable_catalog();
+
+            // The search makes and unmakes turns on a silent copy, so listeners of the game see none of them.
+            // Attacks are made with known dodge outcomes, so the copy needs no random stream.
+            std::unique_ptr<game_status_t> scratch(game->clone(nullptr));
+            auto player = scratch->get_player_team_mutable();
+            auto enemy = scratch->get_enemy_team_mutable(scratch->get_current_enemy_index());
+            m_player_count = (int) player->get_creature_count();
+            m_enemy_first_creature = (int) (enemy->get_creature_mutable(0) - player->get_creature_mutable(0));
+
+            m_undo.clear();
+            scratch->set_undo_stack(&m_undo);
+            m_deadline = std::chrono::steady_clock::now() + m_config.time_budget;
+            m_nodes = 0;
+
+            const uint64_t hash = compute_hash(scratch.get());
+            move_t result = root_moves[0];
+
+            try{
+                for (int depth = 1; depth <= m_config.max_depth; ++depth) {
+                    float best = player_team ? -1.0f : 2.0f;
+                    move_t best_move = root_moves[0];
+                    for (const auto& move : root_moves) {
+                        float value = search_move(scratch.get(), hash, 0, depth, move);
+                        if(player_team ? value > best : value < best){
+                            best = value;
+                            best_move = move;
+                        }
+                    }
+                    result = best_move;
+                    if(best <= 0 || best >= 1) break;
+                }
+            }
+            catch (const timeout_t&) {
+                // The copy is dropped in the middle of the interrupted iteration.
+            }
+
+            return result;
+        }
+
+        /// Searches for the best move of the side which is to move.
+        /// @param game Contemporary game status. Must be created by the logic module. (Not modified.)
+        /// @return Best move of the deepest completed iteration.
+        move_t find_move(game_status_i* game){
+            auto concrete_game = dynamic_cast<game_status_t*>(game);
+            if(concrete_game == nullptr)
+                throw std::invalid_argument("Search requires game created by the logic module.");
+            return find_move(concrete_game);
+        }
+    };
+}
@@ -0,0 +1,932 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+
+#include "maths2.h"
+#include "rng.h"
+#include "events.h"
+#include "data_model.h"
+#include "data_importing.h"
+#include "buffered_numeric_io_operations.h"
+#include "arena.h"
+#include "metrics.h"
+#include "tracing.h"
+#include "allocations.h"
+
+using std::string;
+using std::cout;
+using std::endl;
+using std::ofstream;
+using std::vector;
+using std::function;
+using std::uint32_t;
+
+
+
+namespace logic{
+    using namespace data_model;
+    using namespace data_importing;
+    using namespace maths2;
+    using namespace rng;
+    using namespace events;
+
+#ifndef TURNS_GAME_COMBAT_EVENTS
+    /// Enables damage and skill use events. Set to 0 to compile them out.
+    #define TURNS_GAME_COMBAT_EVENTS 1
+#endif
+#ifndef TURNS_GAME_TURN_EVENTS
+    /// Enables selection, obligatory turn and enemy pass events. Set to 0 to compile them out.
+    #define TURNS_GAME_TURN_EVENTS 1
+#endif
+#ifndef TURNS_GAME_PROGRESS_EVENTS
+    /// Enables death and evolution events. Set to 0 to compile them out.
+    #define TURNS_GAME_PROGRESS_EVENTS 1
+#endif
+
+    constexpr bool combat_events_enabled = TURNS_GAME_COMBAT_EVENTS != 0;
+    constexpr bool turn_events_enabled = TURNS_GAME_TURN_EVENTS != 0;
+    constexpr bool progress_events_enabled = TURNS_GAME_PROGRESS_EVENTS != 0;
+
+    /// Sinks of all events announced by a game. Each game (or simulation worker) owns its own sinks.
+    struct game_events_t{
+        /// Event invoked after damaging a creature by a different creature.
+        event<damage_i, combat_events_enabled> on_damage;
+        /// Event invoked after dealing enough damage_default_attack to declare a creature dead.
+        event<creature_i*, progress_events_enabled> on_death;
+        /// Event invoked after a selection.
+        event<selection_i, turn_events_enabled> on_selection;
+        /// Event invoked after an evolution.
+        event<creature_i*, progress_events_enabled> on_evolution;
+        /// Event invoked whenever some turn is forced.
+        event<player_action, turn_events_enabled> on_obligatory_turn;
+        /// Event invoked before passing defeated enemy.
+        event<int, turn_events_enabled> on_enemy_pass;
+        /// Event invoked on skill use.
+        event<skill_type, combat_events_enabled> on_skill_use;
+    };
+
+    /// Mutable state of a creature. Its metadata is referenced by the catalog index.
+    struct creature_state_t{
+        int evolution_index;
+        float health;
+        float exp;
+    };
+
+    struct team_state_t{
+        int selection_index;
+        int creature_count;
+    };
+
+    /// Value copy of the full state of a game. Teams are stored player team first;
+    /// creatures of all teams follow in the same order. Copying into a snapshot of the same game
+    /// reuses its storage, so it costs two memcpy calls.
+    struct game_snapshot_t{
+        bool is_player_turn;
+        int turn_index;
+        int enemy_index;
+        vector<team_state_t> teams;
+        vector<creature_state_t> creatures;
+    };
+
+    /// Deltas recorded by a game, sufficient to undo its changes one by one in time proportional to their size.
+    /// Every make_turn_* call, swap_turns and try_fight_next_enemy is one change. The random stream is not rewound.
+    struct undo_stack_t{
+        struct change_t{
+            bool is_player_turn;
+            int turn_index;
+            int enemy_index;
+            /// Index of the team whose selection was changed (or -1).
+            int team_index;
+            int selection_index;
+            /// Index of the first creature delta of the change.
+            int first_creature_delta;
+        };
+
+        struct creature_delta_t{
+            int creature_index;
+            creature_state_t state;
+        };
+
+        vector<change_t> changes;
+        vector<creature_delta_t> creature_deltas;
+
+        size_t get_change_count() const { return changes.size(); }
+
+        void clear(){
+            changes.clear();
+            creature_deltas.clear();
+        }
+    };
+
+
+    namespace internal
+    {
+        class creature_t final : public creature_i{
+        private:
+            float m_health;
+            float m_exp;
+            int m_evolution_index;
+
+        public:
+            /// Creates new instance of given type of creature.
+            /// @param evolution_index Catalog index of the creature evolution.
+            /// @param health Initial health.
+            /// @param exp Initial experience.
+            creature_t(int evolution_index, float health, float exp) :
+                    m_health(health), m_exp(exp), m_evolution_index(evolution_index) {}
+
+            float get_health() override { return m_health; }
+            float get_exp() override { return m_exp; }
+            bool is_alive() override { return m_health > 0; }
+            const evolution_meta_t* get_evolution() override { return &catalog->evolutions[m_evolution_index]; }
+            const creature_meta_t* get_creature() override { return &catalog->creatures[get_evolution()->creature_index]; }
+            int get_evolution_index() const { return m_evolution_index; }
+
+            /// Same as creature_i::can_evolute, without virtual calls.
+            bool can_evolute() {
+                const evolution_meta_t& evolution = catalog->evolutions[m_evolution_index];
+                return m_exp >= evolution.required_exp && evolution.next_evolution != no_evolution && m_health > 0;
+            }
+
+            creature_state_t get_state() const { return {m_evolution_index, m_health, m_exp}; }
+            /// Overwrites the state. Counts of living creatures are kept by game_status_t::set_creature_state.
+            void set_state(const creature_state_t& state){
+                m_evolution_index = state.evolution_index;
+                m_health = state.health;
+                m_exp = state.exp;
+            }
+
+            void evolute() {
+                if(!can_evolute())
+                {
+                    cout << "INTERNAL ERROR: Can not evolute the creature!" << std::endl;
+                    return;
+                }
+                m_evolution_index = get_evolution()->next_evolution;
+
+                auto evolution = get_evolution();
+                auto missing_hp = evolution->max_health - m_health;
+                m_health = evolution->max_health - missing_hp / 2.0f;
+            }
+
+            void damage_anonymously(float p) {
+                m_health -= abs(p);
+                m_health = clamp(m_health, 0, get_evolution()->max_health);
+            }
+
+
+            void give_exp(float p) {
+                m_exp += p;
+                m_exp = clamp(m_exp, 0, get_evolution()->required_exp);
+            }
+
+            void heal_full(){
+                m_health = get_evolution()->max_health;
+            }
+        };
+
+
+
+        /// Team of creatures stored contiguously in the arena of its game. Does not own the creatures.
+        class team_t final : public team_i{
+        private:
+            int m_selection_index;
+            creature_t* m_creatures;
+            int m_creature_count;
+            /// Number of living creatures, maintained by the game on every death and revival.
+            int m_alive_count;
+
+
+            int checked(int index) const {
+                assert(index >= 0 && index < m_creature_count && "Creature index out of the team.");
+                return index;
+            }
+
+        public:
+            /// Default constructor initializing team directly.
+            /// @param selection_index Index of creature fighting on the arena.
+            /// @param creatures Pointer to the first creature of the team. (Not disposed.)
+            /// @param creature_count Number of creatures of the team.
+            team_t(int selection_index, creature_t* creatures, int creature_count) :
+                    m_selection_index(selection_index), m_creatures(creatures), m_creature_count(creature_count) {
+                recount_alive();
+            }
+
+            // Indices are checked in debug builds only. Loads validate them, and the console and the AI pass valid ones.
+            size_t get_creature_count() override { return m_creature_count; }
+            creature_t* get_creature(int index) override { return &m_creatures[checked(index)]; }
+            creature_t* get_selected_creature() override { return &m_creatures[checked(m_selection_index)]; }
+            int get_selected_creature_index() override { return m_selection_index; }
+
+            creature_t* get_creature_mutable(int index) { return &m_creatures[checked(index)]; }
+            creature_t* get_selected_creature_mutable() { return &m_creatures[checked(m_selection_index)]; }
+            void set_selected_creature(int index) {
+                m_selection_index = index;
+            }
+
+            bool is_defeated() override { return m_alive_count == 0; }
+
+            bool is_creature_selectable(int index) override { return m_creatures[checked(index)].is_alive(); }
+
+            int get_selectable_creature_count() override { return m_alive_count; }
+
+            /// @return True when the creature belongs to the team.
+            bool contains(const creature_t* creature) const {
+                return creature >= m_creatures && creature < m_creatures + m_creature_count;
+            }
+
+            /// Extends the team by the creature placed right after its last one.
+            void grow() {
+                if(m_creatures[m_creature_count].is_alive()) m_alive_count++;
+                m_creature_count++;
+            }
+
+            /// Adjusts number of living creatures.
+            /// @param change 1 for revived creature, -1 for dead one.
+            void count_alive_change(int change) { m_alive_count += change; }
+
+            /// Counts living creatures anew.
+            void recount_alive() {
+                m_alive_count = 0;
+                for (int i = 0; i < m_creature_count; ++i) {
+                    if(m_creatures[i].is_alive()) m_alive_count++;
+                }
+            }
+        };
+
+
+
+        /// Game played in the arena. The class is final and its accessors return concrete types, so code templated
+        /// on the game type (simulation, AI search) binds every call statically; game_status_i serves the console.
+        class game_status_t final : public game_status_i{
+        private:
+            bool m_is_player_turn;
+            int m_turn_index;
+            int m_enemy_index;
+            /// Block holding all teams and creatures of the game.
+            memory::arena_t m_arena;
+            /// Player team followed by the enemy teams.
+            team_t* m_teams;
+            int m_team_count;
+            creature_t* m_creatures;
+            int m_creature_count;
+            /// Number of enemy teams without living creatures, maintained with the alive counts of the teams.
+            int m_defeated_enemy_count;
+            rng::context_t* m_rng;
+            game_events_t* m_events;
+            /// Stack recording changes of the game. Null when changes are not recorded.
+            undo_stack_t* m_undo = nullptr;
+            /// Informs if the game is really played, so its turns are counted by the metrics registry and traced.
+            /// Copies made by clone or from snapshots (AI search) are never instrumented.
+            bool m_is_instrumented = false;
+
+        public:
+
+            int get_turn_index() override { return m_turn_index; }
+            bool is_player_turn() override { return m_is_player_turn; }
+
+            size_t get_enemy_teams_count() override{ return m_team_count - 1; }
+            team_t* get_player_team() override { return &m_teams[0]; }
+            team_t* get_enemy_team(int index) override{ return &m_teams[index + 1]; }
+            team_t* get_player_team_mutable() { return &m_teams[0]; }
+            team_t* get_enemy_team_mutable(int index){ return &m_teams[index + 1]; }
+            int get_current_enemy_index() override { return m_enemy_index; }
+
+            bool are_all_enemy_teams_defeated() override { return m_defeated_enemy_count == m_team_count - 1; }
+
+            // Same as the helpers of game_status_i, without virtual calls.
+            team_t* get_current_enemy_team() { return &m_teams[m_enemy_index + 1]; }
+            bool is_round_over() { return m_teams[0].is_defeated() || get_current_enemy_team()->is_defeated(); }
+            bool is_game_over() { return m_teams[0].is_defeated() || are_all_enemy_teams_defeated(); }
+
+            /// Creates new game based on initial values.
+            /// @param player_picks Picks of the player. (Not disposed.)
+            /// @param difficulty Difficulty of the game. (Not disposed.)
+            /// @param random Random stream driving the game. (Not disposed.)
+            /// @param events Sinks of the game events. Null for a silent game. (Not disposed.)
+            game_status_t(
+                const vector<const struct creature_meta_t*>* player_picks,
+                const difficulty_t* difficulty,
+                rng::context_t* random,
+                game_events_t* events = nullptr)
+            {
+                m_rng = random;
+                m_events = events;
+                m_is_player_turn = true;
+                m_turn_index = 0;
+                m_enemy_index = 0;
+
+                int creature_count = (int) player_picks->size();
+                for (int i = 0; i < difficulty->enemy_count; ++i) {
+                    creature_count += difficulty->player_count + i;
+                }
+                reserve(1 + difficulty->enemy_count, creature_count);
+
+                auto player_team = append_team(0);
+                for (auto pick : *player_picks) {
+                    append_default_creature(player_team, pick);
+                }
+
+                for (int i = 0; i < difficulty->enemy_count; ++i) {
+                    auto enemy_team = append_team(0);
+                    for (int c = 0; c < difficulty->player_count + i; ++c) {
+                        append_default_creature(enemy_team, find_random_creature_metadata(*m_rng));
+                    }
+                }
+            }
+
+            /// Creates new game status directly. Teams and creatures are appended afterwards, team by team.
+            /// @param is_player_turn
+            /// @param turn_index
+            /// @param enemy_team_index
+            /// @param team_count Number of all teams (including the player's one).
+            /// @param creature_count Number of all creatures of all teams.
+            /// @param random
+            /// @param events
+            game_status_t(bool is_player_turn, int turn_index, int enemy_team_index,
+                          int team_count, int creature_count,
+                          rng::context_t* random, game_events_t* events = nullptr) :
+                m_is_player_turn(is_player_turn), m_turn_index(turn_index),
+                m_enemy_index(enemy_team_index), m_rng(random), m_events(events) {
+                reserve(team_count, creature_count);
+            }
+
+            game_status_t(const game_status_t&) = delete;
+            game_status_t& operator=(const game_status_t&) = delete;
+
+            /// Creates new game from the snapshot.
+            /// @param snapshot State of the game.
+            /// @param random Random stream driving the game. (Not disposed.)
+            /// @param events Sinks of the game events. Null for a silent game. (Not disposed.)
+            game_status_t(const game_snapshot_t& snapshot, rng::context_t* random, game_events_t* events = nullptr) :
+                game_status_t(snapshot.is_player_turn, snapshot.turn_index, snapshot.enemy_index,
+                              (int) snapshot.teams.size(), (int) snapshot.creatures.size(), random, events) {
+                for (const auto& team_state : snapshot.teams) {
+                    team_t* team = append_team(team_state.selection_index);
+                    for (int c = 0; c < team_state.creature_count; ++c) {
+                        const creature_state_t& creature = snapshot.creatures[m_creature_count];
+                        append_creature(team, creature.evolution_index, creature.health, creature.exp);
+                    }
+                }
+            }
+
+            /// Copies the game into new, independent game. Copies share nothing but the catalog.
+            /// @param random Random stream driving the copy. (Not disposed.)
+            /// @param events Sinks of the copy events. Null for a silent copy. (Not disposed.)
+            /// @return Copy of the game.
+            game_status_t* clone(rng::context_t* random, game_events_t* events = nullptr){
+                game_snapshot_t snapshot;
+                save_snapshot(snapshot);
+                return new game_status_t(snapshot, random, events);
+            }
+
+            /// Copies the full state of the game into the snapshot, reusing its storage.
+            /// @param snapshot Overwritten snapshot.
+            void save_snapshot(game_snapshot_t& snapshot){
+                snapshot.is_player_turn = m_is_player_turn;
+                snapshot.turn_index = m_turn_index;
+                snapshot.enemy_index = m_enemy_index;
+
+                snapshot.teams.resize(m_team_count);
+                for (int t = 0; t < m_team_count; ++t) {
+                    snapshot.teams[t] = {m_teams[t].get_selected_creature_index(), (int) m_teams[t].get_creature_count()};
+                }
+                snapshot.creatures.resize(m_creature_count);
+                for (int c = 0; c < m_creature_count; ++c) {
+                    snapshot.creatures[c] = m_creatures[c].get_state();
+                }
+            }
+
+            /// Checks health or experience by its bits: finite and not negative, negative zero included.
+            static bool is_valid_amount(float value){
+                uint32_t bits;
+                std::memcpy(&bits, &value, sizeof(bits));
+                return (bits < 0x7f800000u) | (bits == 0x80000000u);
+            }
+
+            /// Restores the game to the snapshot taken from this game or its copy (or throws exception).
+            /// The whole snapshot is checked, as the loaders check saves, before anything changes.
+            /// @param snapshot Restored state.
+            void restore_snapshot(const game_snapshot_t& snapshot){
+                if((int) snapshot.teams.size() != m_team_count || (int) snapshot.creatures.size() != m_creature_count)
+                    throw std::invalid_argument("Snapshot was taken from a game of different layout.");
+                if(snapshot.enemy_index < 0 || snapshot.enemy_index >= m_team_count - 1)
+                    throw std::invalid_argument("Snapshot has invalid current enemy index.");
+                // Equal totals may still split differently into teams.
+                for (int t = 0; t < m_team_count; ++t) {
+                    const team_state_t& team = snapshot.teams[t];
+                    if(team.creature_count != (int) m_teams[t].get_creature_count())
+                        throw std::invalid_argument("Snapshot was taken from a game of different layout.");
+                    if(team.selection_index < 0 || team.selection_index >= team.creature_count)
+                        throw std::invalid_argument("Snapshot has invalid selection index.");
+                }
+                // Summed without branching, as the search restores snapshots on every playout.
+                const auto evolution_count = (unsigned) catalog->evolution_count;
+                bool are_creatures_valid = true;
+                for (const creature_state_t& creature : snapshot.creatures) {
+                    are_creatures_valid &= ((unsigned) creature.evolution_index < evolution_count) &
+                                           is_valid_amount(creature.health) & is_valid_amount(creature.exp);
+                }
+                if(!are_creatures_valid)
+                    throw std::invalid_argument("Snapshot has invalid creature state.");
+
+                m_is_player_turn = snapshot.is_player_turn;
+                m_turn_index = snapshot.turn_index;
+                m_enemy_index = snapshot.enemy_index;
+
+                for (int t = 0; t < m_team_count; ++t) {
+                    m_teams[t].set_selected_creature(snapshot.teams[t].selection_index);
+                }
+                for (int c = 0; c < m_creature_count; ++c) {
+                    m_creatures[c].set_state(snapshot.creatures[c]);
+                }
+                recount_alive();
+            }
+
+            /// Overwrites state of the creature, keeping counts of living creatures and defeated teams.
+            /// @param creature Creature of the game.
+            /// @param state New state.
+            void set_creature_state(creature_t* creature, const creature_state_t& state){
+                const bool was_alive = creature->is_alive();
+                creature->set_state(state);
+                count_alive_change(creature, was_alive);
+            }
+
+            /// Overrides the turn state of the game. Teams are not changed.
+            /// @param is_player_turn
+            /// @param turn_index
+            /// @param enemy_index Index of the current enemy team.
+            void set_turn_state(bool is_player_turn, int turn_index, int enemy_index){
+                m_is_player_turn = is_player_turn;
+                m_turn_index = turn_index;
+                m_enemy_index = enemy_index;
+            }
+
+            /// Starts or stops recording changes of the game.
+            /// @param undo Stack receiving the changes. Null stops recording. (Not disposed.)
+            void set_undo_stack(undo_stack_t* undo){ m_undo = undo; }
+            /// @return Stack recording changes of the game (or null).
+            undo_stack_t* get_undo_stack() const { return m_undo; }
+
+            /// Marks the game as really played (or not), so that its turns are counted by the metrics registry and traced.
+            /// @param is_instrumented Informs if the turns are counted.
+            void set_instrumented(bool is_instrumented){ m_is_instrumented = is_instrumented; }
+            bool is_instrumented() const { return m_is_instrumented; }
+
+            /// Reverts the last recorded change of the game.
+            /// @return False when there is no recorded change.
+            bool undo_last_change(){
+                if(m_undo == nullptr || m_undo->changes.empty()) return false;
+                const undo_stack_t::change_t& change = m_undo->changes.back();
+
+                // Deltas are reverted newest first, so a creature changed twice ends in its oldest state.
+                while ((int) m_undo->creature_deltas.size() > change.first_creature_delta){
+                    const auto& delta = m_undo->creature_deltas.back();
+                    set_creature_state(&m_creatures[delta.creature_index], delta.state);
+                    m_undo->creature_deltas.pop_back();
+                }
+                if(change.team_index >= 0)
+                    m_teams[change.team_index].set_selected_creature(change.selection_index);
+
+                m_is_player_turn = change.is_player_turn;
+                m_turn_index = change.turn_index;
+                m_enemy_index = change.enemy_index;
+                m_undo->changes.pop_back();
+                return true;
+            }
+
+            /// Appends new, empty team. The first appended team belongs to the player.
+            /// @param selection_index Index of creature fighting on the arena.
+            /// @return Appended team.
+            team_t* append_team(int selection_index){
+                // Enemy team starts empty, hence defeated, until its first living creature is appended.
+                if(m_team_count > 0) m_defeated_enemy_count++;
+                return new (&m_teams[m_team_count++]) team_t(selection_index, &m_creatures[m_creature_count], 0);
+            }
+
+            /// Appends creature to the last appended team.
+            /// @param team Last appended team.
+            /// @param evolution_index Catalog index of the creature evolution.
+            /// @param health Initial health.
+            /// @param exp Initial experience.
+            void append_creature(team_t* team, int evolution_index, float health, float exp){
+                new (&m_creatures[m_creature_count++]) creature_t(evolution_index, health, exp);
+                const bool was_defeated = team->is_defeated();
+                team->grow();
+                if(team != &m_teams[0] && team->is_defeated() != was_defeated)
+                    m_defeated_enemy_count--;
+            }
+
+
+            bool can_make_turn_select_any_creature(bool player_team) override{
+                return get_team(player_team)->get_selectable_creature_count() > 0;
+            }
+            bool can_make_turn_select_creature(bool player_team, int selection_index) override {
+                return get_team(player_team)->is_creature_selectable(selection_index);
+            }
+            bool can_make_turn_evolute(bool player_team) override {
+                return get_team(player_team)->get_selected_creature()->can_evolute();
+            }
+            bool can_make_turn_use_attack(bool player_team) override {
+                return get_team(player_team)->get_selected_creature()->is_alive();
+            }
+            bool can_make_turn_use_skill(bool player_team) override {
+                return
+                        get_team(player_team)->get_selected_creature()->is_alive() &&
+                        get_team(player_team)->get_selected_creature()->get_evolution()->skill_type != skill_type::none;
+            }
+
+            void make_turn_select_creature(bool player_team, int selection_index) override {
+                tracing::span_t span("make_turn_select_creature", m_is_instrumented);
+                begin_change(get_team_index(player_team));
+                get_team(player_team)->set_selected_creature(selection_index);
+                count_metric(metrics::counter::selection_turns);
+                if(m_events != nullptr && m_events->on_selection.has_listeners())
+                    m_events->on_selection.invoke({selection_index, get_team(player_team)->get_selected_creature(), player_team});
+                m_turn_index++;
+            }
+            void make_turn_evolute(bool player_team) override {
+                tracing::span_t span("make_turn_evolute", m_is_instrumented);
+                creature_t* creature = get_team(player_team)->get_selected_creature_mutable();
+                begin_change();
+                remember_creature(creature);
+                creature->evolute();
+                count_metric(metrics::counter::evolution_turns);
+                if(m_events != nullptr && m_events->on_evolution.has_listeners())
+                    m_events->on_evolution.invoke(creature);
+                m_turn_index++;
+            }
+            void make_turn_use_attack(bool player_team) override {
+                const float miss_possibility = 1 - get_dodge_probability(player_team);
+                make_turn_use_attack(player_team, m_rng->next_float_01() > miss_possibility);
+            }
+
+            /// Attacks with known outcome of the dodge roll, without using the random stream.
+            /// @param player_team Informs if the player's team attacks.
+            /// @param is_dodged Informs if the target dodges the attack.
+            void make_turn_use_attack(bool player_team, bool is_dodged) {
+                tracing::span_t span("make_turn_use_attack", m_is_instrumented);
+                auto target = get_team(!player_team)->get_selected_creature_mutable();
+                auto attacker = get_team(player_team)->get_selected_creature_mutable();
+
+                begin_change();
+                damage_default_attack(attacker, target, is_dodged);
+                count_metric(metrics::counter::attack_turns);
+                m_turn_index++;
+            }
+
+            /// Probability that the attack of given side is dodged by the target on the arena.
+            /// @param player_team Informs if the player's team attacks.
+            /// @return Dodge probability (agility of the target in percents divided by 100).
+            float get_dodge_probability(bool player_team) {
+                return get_team(!player_team)->get_selected_creature()->get_evolution()->agility / 100.0f;
+            }
+            void make_turn_use_skill(bool player_team) override {
+                tracing::span_t span("make_turn_use_skill", m_is_instrumented);
+                team_t* target_team = get_team(!player_team);
+                team_t* attacker_team = get_team(player_team);
+                auto target = target_team->get_selected_creature_mutable();
+                auto attacker = attacker_team->get_selected_creature_mutable();
+
+                auto skill_type = attacker->get_evolution()->skill_type;
+                float skill_value = attacker->get_evolution()->skill_power / 100.0f;
+
+                begin_change();
+                count_metric(metrics::counter::skill_turns);
+                if(m_events != nullptr && m_events->on_skill_use.has_listeners())
+                    m_events->on_skill_use.invoke(skill_type);
+
+                switch(skill_type) {
+                    case skill_type::none: {
+                        throw std::exception("This creature has no skill!");
+                    }
+                    case skill_type::hp_ratio_damage: {
+                        true_attack(attacker, target, target->get_health() * skill_value);
+                    }break;
+                    case skill_type::max_hp_ratio_damage:{
+                        true_attack(attacker, target, target->get_evolution()->max_health * skill_value);
+                    }break;
+                    case skill_type::massive_damage:{
+                        for (int i = 0; i < attacker_team->get_creature_count(); ++i) {
+                            auto creature = attacker_team->get_creature_mutable(i);
+                            if(!creature->is_alive()) continue;
+                            true_attack(attacker, creature, skill_value);
+                        }
+                    }break;
+                }
+                m_turn_index++;
+            }
+
+
+            bool try_make_obligatory_turn(bool player_team) override{
+                auto team = get_team(player_team);
+
+                if(!team->get_selected_creature()->is_alive() &&
+                    team->get_selectable_creature_count() == 1){
+                    for (int i = 0; i < team->get_creature_count(); ++i) {
+                        if(team->is_creature_selectable(i)) {
+                            make_turn_select_creature(player_team, i);
+                            if(m_events != nullptr && m_events->on_obligatory_turn.has_listeners())
+                                m_events->on_obligatory_turn.invoke(player_action::creature_reselection);
+                            return true;
+                        }
+                    }
+                }
+
+                return false;
+            }
+
+            void swap_turns() override {
+                begin_change();
+                m_is_player_turn = !m_is_player_turn;
+            }
+
+            bool try_fight_next_enemy() override{
+                if(!get_current_enemy_team()->is_defeated())
+                    throw std::invalid_argument("Fight with next enemy team requires defeating contemporary one.");
+
+                if(get_current_enemy_index() == get_enemy_teams_count() - 1)
+                    return false;
+
+                if(m_events != nullptr && m_events->on_enemy_pass.has_listeners())
+                    m_events->on_enemy_pass.invoke(m_enemy_index);
+                begin_change();
+                m_enemy_index++;
+
+                {
+                    auto player_team = get_player_team_mutable();
+                    for (int i = 0; i < player_team->get_creature_count(); ++i) {
+                        auto creature = player_team->get_creature_mutable(i);
+                        const bool was_alive = creature->is_alive();
+                        remember_creature(creature);
+                        creature->heal_full();
+                        count_alive_change(creature, was_alive);
+                        creature->give_exp(5);
+                    }
+                }
+
+                return true;
+            }
+
+            /// Releases all teams and creatures at once, along with the arena.
+            ~game_status_t() override = default;
+
+        private:
+            /// Allocates the arena for all teams and creatures of the game.
+            /// @param team_count Number of all teams.
+            /// @param creature_count Number of all creatures.
+            void reserve(int team_count, int creature_count){
+                allocations::scope_t scope(allocations::subsystem::engine);
+                m_arena = memory::arena_t(
+                        memory::arena_t::footprint<team_t>(team_count) +
+                        memory::arena_t::footprint<creature_t>(creature_count));
+                m_teams = m_arena.allocate<team_t>(team_count);
+                m_creatures = m_arena.allocate<creature_t>(creature_count);
+                m_team_count = 0;
+                m_creature_count = 0;
+                m_defeated_enemy_count = 0;
+            }
+
+            /// Finds team of the creature.
+            team_t* find_team(const creature_t* creature){
+                for (int t = 0; t < m_team_count; ++t) {
+                    if(m_teams[t].contains(creature)) return &m_teams[t];
+                }
+                throw std::invalid_argument("Creature does not belong to the game.");
+            }
+
+            /// Updates counts of living creatures and defeated teams after the creature died or revived.
+            /// @param creature Changed creature.
+            /// @param was_alive Informs if the creature was alive before the change.
+            void count_alive_change(creature_t* creature, bool was_alive){
+                if(creature->is_alive() == was_alive) return;
+
+                team_t* team = find_team(creature);
+                const bool was_defeated = team->is_defeated();
+                team->count_alive_change(was_alive ? -1 : 1);
+                if(team != &m_teams[0] && team->is_defeated() != was_defeated)
+                    m_defeated_enemy_count += was_defeated ? -1 : 1;
+            }
+
+            /// Counts living creatures and defeated teams anew, after states of creatures were overwritten.
+            void recount_alive(){
+                m_defeated_enemy_count = 0;
+                for (int t = 0; t < m_team_count; ++t) {
+                    m_teams[t].recount_alive();
+                    if(t > 0 && m_teams[t].is_defeated()) m_defeated_enemy_count++;
+                }
+            }
+
+            /// Appends creature of default evolution.
+            /// @param team Last appended team.
+            /// @param pick Metadata of the creature. (Not disposed.)
+            void append_default_creature(team_t* team, const creature_meta_t* pick){
+                auto evolution = find_default_evolution_for_creature(pick);
+                append_creature(team, pick->first_evolution, evolution->max_health, 0);
+            }
+
+            /// Gets contemporary team involved in fight.
+            /// @param player_team Informs if the player's team is mentioned.
+            /// @return Pointer to mutable fighting team.
+            team_t* get_team(bool player_team){
+                return &m_teams[get_team_index(player_team)];
+            }
+
+            int get_team_index(bool player_team) const {
+                return player_team ? 0 : m_enemy_index + 1;
+            }
+
+            /// Records the beginning of a change, if changes are recorded.
+            /// @param team_index Index of the team whose selection is going to change (or -1).
+            void begin_change(int team_index = -1){
+                if(m_undo == nullptr) return;
+                allocations::scope_t scope(allocations::subsystem::engine);
+                m_undo->changes.push_back({
+                    m_is_player_turn, m_turn_index, m_enemy_index,
+                    team_index, team_index >= 0 ? m_teams[team_index].get_selected_creature_index() : -1,
+                    (int) m_undo->creature_deltas.size()});
+            }
+
+            /// Records state of the creature before it is changed, if changes are recorded.
+            void remember_creature(creature_t* creature){
+                if(m_undo == nullptr) return;
+                allocations::scope_t scope(allocations::subsystem::engine);
+                m_undo->creature_deltas.push_back({(int) (creature - m_creatures), creature->get_state()});
+            }
+
+            void count_metric(metrics::counter id){
+                if(m_is_instrumented) metrics::count(id);
+            }
+
+            void true_attack(creature_t* attacker, creature_t* target, float damage){
+                remember_creature(target);
+                const bool was_alive = target->is_alive();
+                target->damage_anonymously(damage);
+                count_alive_change(target, was_alive);
+                count_metric(metrics::counter::damage_events);
+                if(m_events != nullptr && m_events->on_damage.has_listeners())
+                    m_events->on_damage.invoke({attacker, target, damage});
+
+                if(!target->is_alive()){
+                    remember_creature(attacker);
+                    attacker->give_exp(target->get_evolution()->bounty_exp);
+                    count_metric(metrics::counter::deaths);
+                    if(m_events != nullptr && m_events->on_death.has_listeners())
+                        m_events->on_death.invoke(target);
+                }
+            }
+
+            void damage_default_attack(creature_t* attacker, creature_t* target, bool is_dodged){
+                const float power = attacker->get_evolution()->strength;
+                const float element_mul = find_element_damage_mul(
+                        attacker->get_creature()->element,
+                        target->get_creature()->element);
+
+                float result_dmg = is_dodged ? 0 : power * element_mul;
+
+                true_attack(attacker, target, result_dmg);
+            }
+        };
+
+
+        constexpr char attributes_separator = '\t';
+        constexpr char records_separator = '\n';
+        constexpr float float_to_int_mul_precision = 10.0f;
+
+        void serialize_team(ofstream& o, team_i* team, int team_id){
+            o << team->get_creature_count() << attributes_separator;
+            o << team->get_selected_creature_index() << attributes_separator;
+            o << records_separator;
+
+            for (int i = 0; i < team->get_creature_count(); ++i) {
+                auto creature = team->get_creature(i);
+                o << creature->get_creature()->id << attributes_separator;
+                o << creature->get_evolution()->level << attributes_separator;
+                o << (int)(creature->get_health() * float_to_int_mul_precision) << attributes_separator;
+                o << (int)(creature->get_exp() * float_to_int_mul_precision);
+                o << records_separator;
+            }
+        }
+    }
+    using namespace logic::internal;
+
+    namespace serialization{
+        using namespace data_importing;
+        using internal::float_to_int_mul_precision;
+
+        game_status_i* open_game(const string& save_name, rng::context_t* random, game_events_t* events = nullptr){
+            metrics::scoped_timer_t timer(metrics::timer::open);
+            tracing::span_t span("open_game");
+            allocations::scope_t scope(allocations::subsystem::serialization);
+            const string full_path = "Saves/" + save_name + ".txt";
+
+            vector<int> buffer = buffered_numeric_io_operations::read_buffered_numbers_file(full_path);
+            int buffer_i = 0;
+            if(buffer.empty())
+                throw std::runtime_error("Can not read save " + full_path + ".");
+
+            function<int()> next_int = [&buffer_i, &buffer]() -> int{
+                return buffer.at(buffer_i++);
+            };
+            function<float()> next_float = [&next_int]() -> float{
+                float as_f = (float) (next_int());
+                return as_f / float_to_int_mul_precision;
+            };
+
+            int
+                team_count = next_int(),
+                current_enemy_index = next_int(),
+                turn_index = next_int();
+
+            bool is_player_turn = next_int() == 1;
+
+            if(team_count < 2)
+                throw std::runtime_error("Save has invalid team count.");
+            if(current_enemy_index < 0 || current_enemy_index >= team_count - 1)
+                throw std::runtime_error("Save has invalid current enemy index.");
+            if(turn_index < 0)
+                throw std::runtime_error("Save has invalid turn index.");
+
+            // Team sizes are known up front, so the whole game fits in one arena. Every team must fit the rest of
+            // the buffer, which bounds the arena by the size of the file.
+            int creature_count = 0;
+            for (int j = 0, buffer_team_i = buffer_i; j < team_count; ++j) {
+                int team_size = buffer.at(buffer_team_i);
+                if(team_size < 1 || team_size > ((int) buffer.size() - buffer_team_i - 2) / 4)
+                    throw std::runtime_error("Save has invalid team size.");
+                creature_count += team_size;
+                buffer_team_i += 2 + 4 * team_size;
+            }
+
+            std::unique_ptr<game_status_t> result(new game_status_t(
+                is_player_turn, turn_index, current_enemy_index,
+                team_count, creature_count, random, events));
+
+            for (int j = 0; j < team_count; ++j) {
+                int team_size = next_int(), selection_index = next_int();
+                if(selection_index < 0 || selection_index >= team_size)
+                    throw std::runtime_error("Save has invalid selection index.");
+
+                auto new_team = result->append_team(selection_index);
+                for (int c = 0; c < team_size; ++c) {
+                    int creature_id2 = next_int(), level2 = next_int();
+
+                    int evolution_index = find_evolution_index_by_ids(creature_id2, level2);
+
+                    float hp2 = next_float(), exp2 = next_float();
+                    if(hp2 < 0 || exp2 < 0)
+                        throw std::runtime_error("Save has invalid creature state.");
+
+                    result->append_creature(new_team, evolution_index, hp2, exp2);
+                }
+            }
+
+            return result.release();
+        }
+
+         void save_game(const string& save_name, game_status_i* game_status){
+            metrics::scoped_timer_t timer(metrics::timer::save);
+            tracing::span_t span("save_game");
+            allocations::scope_t scope(allocations::subsystem::serialization);
+            cout << save_name << " saved." << records_separator;
+
+            const string full_path = "Saves/" + save_name + ".txt";
+
+            ofstream o(full_path);
+
+            o << (game_status->get_enemy_teams_count() + 1);
+            o << attributes_separator << game_status->get_current_enemy_index();
+            o << attributes_separator << game_status->get_turn_index();
+            o << attributes_separator << game_status->is_player_turn();
+            o << records_separator;
+
+            serialize_team(o, game_status->get_player_team(), 0);
+
+            for (int i = 0; i < game_status->get_enemy_teams_count(); ++i) {
+                serialize_team(o, game_status->get_enemy_team(i), i + 1);
+            }
+
+            o.close();
+        }
+    }
+
+    /// Creates new game using parsed player input.
+    /// @param player_picks Metadata(s) of desired player picks.
+    /// @param difficulty Metadata of desired difficulty.
+    /// @param random Random stream driving the game. (Not disposed.)
+    /// @param events Sinks of the game events. (Not disposed.)
+    /// @return New game instance.
+    game_status_i* start_new_game(const vector<const creature_meta_t*>* player_picks, const difficulty_t* difficulty,
+                                  rng::context_t* random, game_events_t* events) {
+        return new game_status_t(player_picks, difficulty, random, events);
+    }
+}
@@ -3,7 +3,23 @@
 #include <string>
 #include <vector>
 #include <functional>
-#include <random>
+#include <memory>
+#include <cmath>
+
+#include "maths2.h"
+#include "rng.h"
+#include "events.h"
+#include "data_model.h"
+#include "data_importing.h"
+#include "logic.h"
+#include "ai.h"
+#include "mcts.h"
+#include "expectimax.h"
+#include "tablebase.h"
+#include "binary_serialization.h"
+#include "metrics.h"
+#include "tracing.h"
+#include "allocations.h"
 
 using std::string;
 using std::cout;
@@ -17,1062 +33,6 @@ using std::function;
 
 
 
-namespace maths2{
-    /// Limits value to specific bounds
-    /// @param t Original value.
-    /// @param min Minimal output.
-    /// @param max Maximal output.
-    /// @return Bounded t.
-    float clamp(float t, float min, float max){
-        if(t > max) return max;
-        if(t < min) return min;
-        return t;
-    }
-
-    /// Prepares a number to be displayed to user.
-    /// @param x Original value.
-    /// @return Human-friendly value.
-    float display_float(float x){
-        if(x <= 0.1f && x > 0.0f) return 0.1f;
-        return round(x * 10) / 10;
-    }
-}
-
-
-
-namespace rng{
-    using std::random_device;
-    using std::default_random_engine;
-    using std::uniform_real_distribution;
-    using std::uniform_int_distribution;
-
-    namespace internal{
-        random_device* rd2;
-        default_random_engine* random_engine;
-        uniform_real_distribution<float>* default_distribution;
-    }
-
-    using namespace rng::internal;
-
-    /// Initializes random number generator.
-    void init_module_rng(){
-        rd2 = new random_device();
-        random_engine = new default_random_engine((*rd2)());
-        default_distribution = new uniform_real_distribution(0.0f, 1.0f);
-
-        cout << "RNG initialized." << endl;
-    }
-
-    /// New random multiplier.
-    /// @return Random number between 0 and 1.
-    float next_random_float_01(){
-        return default_distribution->operator()(*random_engine);
-    }
-
-    /// Returns index of random element.
-    /// @param len Length of the collection.
-    /// @return Random index.
-    int next_random_index(size_t len){
-        int len2 = static_cast<size_t>(len);
-        uniform_int_distribution distribution(0, len2 - 1);
-        return distribution(*internal::random_engine);
-    }
-}
-
-
-
-namespace events{
-    /// Utility class to announce invocation of some one-argument event.
-    /// @tparam args_t Type of the argument.
-    template<class args_t>
-    class event{
-    private:
-        vector<function<void(args_t)>> listeners;
-
-    public:
-        /// Adds function to invoke list making it a listener.
-        /// @param listener New listener.
-        void subscribe(function<void(args_t)> listener){
-            listeners.push_back(listener);
-        }
-
-        /// Invokes all listeners.
-        /// @param args Argument passed to all listeners.
-        void invoke(args_t args){
-            for (const auto& listener : listeners) {
-                listener(args);
-            }
-        }
-    };
-}
-
-
-
-namespace data_model{
-    enum class element{
-        water = 0,   earth = 1,   air = 2,
-        fire = 3,    ice = 4,     metal = 5,
-        none = 7,
-    };
-
-    enum class skill_type{
-        /// No skill
-        none = 0,
-
-        /// Damage applied to all enemy team members.
-        massive_damage = 1,
-
-        /// Attack of value corresponding to max health of the enemy (evolution).
-        max_hp_ratio_damage = 2,
-
-        /// Attack of value corresponding to current (not max) health of the enemy (evolution).
-        hp_ratio_damage = 3,
-    };
-
-    struct difficulty_t{
-        string name;
-        float out_dmg_mul;
-        float in_dmg_mul;
-        int enemy_count;
-        int player_count;
-    };
-
-    struct evolution_meta_t{
-        int creature_id;
-        int level;
-
-        string name;
-        float strength;
-        float max_health;
-        float agility;
-        float bounty_exp;
-        float required_exp;
-
-        skill_type skill_type;
-        float skill_power;
-
-        const evolution_meta_t* next_evolution;
-    };
-
-    struct creature_meta_t{
-        int id;
-        string name;
-        element element;
-    };
-
-    enum class player_action{
-        none = 0,
-        attack = 1,
-        skill_use = 2,
-        creature_reselection = 4,
-        evolution = 8,
-    };
-
-
-    class creature_i{
-    public:
-        virtual float get_health() = 0;
-        virtual float get_exp() = 0;
-        virtual bool is_alive() = 0;
-        virtual const evolution_meta_t* get_evolution() = 0;
-        virtual const creature_meta_t* get_creature() = 0;
-
-        bool can_evolute();
-    };
-
-    class team_i{
-    public:
-        virtual size_t get_creature_count() = 0;
-        virtual creature_i* get_creature(int index) = 0;
-        virtual creature_i* get_selected_creature() = 0;
-        virtual int get_selected_creature_index() = 0;
-        virtual bool is_creature_selectable(int index) = 0;
-        int get_selectable_creature_count();
-
-        virtual bool is_defeated() = 0;
-    };
-
-    int team_i::get_selectable_creature_count() {
-        int result = 0;
-        for (int i = 0; i < get_creature_count(); ++i) {
-            if(get_creature(i)->is_alive()) result++;
-        }
-        return result;
-    }
-
-    class game_status_i{
-    public:
-        virtual int get_turn_index() = 0;
-        virtual bool is_player_turn() = 0;
-        virtual team_i* get_player_team() = 0;
-        virtual size_t get_enemy_teams_count() = 0;
-        virtual team_i* get_enemy_team(int index) = 0;
-        virtual int get_current_enemy_index() = 0;
-
-        bool are_all_enemy_teams_defeated();
-        bool is_round_over();
-        bool is_game_over();
-        team_i* get_current_enemy_team();
-
-        virtual bool can_make_turn_select_any_creature(bool player_team) = 0;
-        virtual bool can_make_turn_select_creature(bool player_team, int selection_index) = 0;
-        virtual bool can_make_turn_evolute(bool player_team) = 0;
-        virtual bool can_make_turn_use_attack(bool player_team) = 0;
-        virtual bool can_make_turn_use_skill(bool player_team) = 0;
-
-        virtual void make_turn_select_creature(bool player_team, int selection_index) = 0;
-        virtual void make_turn_evolute(bool player_team) = 0;
-        virtual void make_turn_use_attack(bool player_team) = 0;
-        virtual void make_turn_use_skill(bool player_team) = 0;
-
-        virtual bool try_make_obligatory_turn(bool player_team) = 0;
-        virtual void swap_turns() = 0;
-        virtual bool try_fight_next_enemy() = 0;
-
-        virtual ~game_status_i() = default;
-    };
-
-
-
-    bool game_status_i::are_all_enemy_teams_defeated() {
-        for (int i = 0; i < get_enemy_teams_count(); ++i) {
-            auto enemy_team = get_enemy_team(i);
-            if(!enemy_team->is_defeated())
-                return false;
-        }
-        return true;
-    }
-
-    bool game_status_i::is_round_over() {
-        bool player_team_defeated = get_player_team()->is_defeated();
-        bool enemy_team_defeated = get_current_enemy_team()->is_defeated();
-        return player_team_defeated || enemy_team_defeated;
-    }
-
-    bool game_status_i::is_game_over() {
-        return get_player_team()->is_defeated() || are_all_enemy_teams_defeated();
-    }
-
-    team_i* game_status_i::get_current_enemy_team() {
-        return get_enemy_team(get_current_enemy_index());
-    }
-
-    bool creature_i::can_evolute() {
-        return
-                this->get_exp() >= this->get_evolution()->required_exp &&
-                this->get_evolution()->next_evolution != nullptr &&
-                this->is_alive();
-    }
-
-
-
-    struct damage_i{
-        creature_i* attacker;
-        creature_i* target;
-        float value;
-    };
-
-    struct selection_i{
-        int index;
-        creature_i* selected;
-        bool is_player_team;
-    };
-
-
-    struct element_interaction_i{
-        const element attacker;
-        const element target;
-        const float multiplier;
-    };
-}
-
-
-
-namespace data_importing{
-    using namespace data_model;
-
-    const vector<const difficulty_t*>* difficulties;
-    const vector<const creature_meta_t*>* creatures;
-    const vector<const evolution_meta_t*>* evolutions;
-    const vector<const element_interaction_i*>* element_interactions;
-
-    const char* difficulties_file_name = "Difficulties.txt";
-    const char* evolutions_file_name = "Evolutions.txt";
-    const char* creatures_file_name = "Creatures.txt";
-    constexpr float element_interaction_damage_mul_buff = 1.5f;
-    constexpr float element_interaction_damage_mul_nerf = 1.0f / element_interaction_damage_mul_buff;
-
-    const char* element_names[] {
-            "Water", "Earth", "Air",
-            "Fire",  "Ice",   "Metal",
-            "None"
-    };
-
-    /// Distinguishes the element by its name (or none).
-    /// @param name Literal name of the element.
-    /// @return Result element or none.
-    element get_element_by_name(const string& name) {
-        int index = 0;
-        for (const char* element_name : element_names) {
-            auto result = name.compare(element_name);
-            if(result == 0) return (element) index;
-        }
-        return element::none;
-    }
-
-    /// Finds default evolution (level 0) by its creature metadata (or throws exception).
-    /// @param creature_metadata Source creature metadata.
-    /// @return Default evolution metadata.
-    const evolution_meta_t* find_default_evolution_for_creature(const creature_meta_t* creature_metadata) {
-        for (auto evolution : *evolutions){
-            if(evolution->creature_id != creature_metadata->id) continue;
-            if(evolution->level != 0) continue;
-            return evolution;
-        }
-        throw std::exception("Creature has no default evolution.");
-    }
-
-    /// Selects random creature metadata.
-    /// @return Random creature metadata.
-    const creature_meta_t* find_random_creature_metadata(){
-        auto random_creature_metadata_id = rand() % creatures->size();
-        return creatures->at(random_creature_metadata_id);
-    }
-
-    /// Finds creature metadata by its id (or throws exception).
-    /// @param creature_id ID of a creature metadata.
-    /// @return Pointer to the creature metadata.
-    const creature_meta_t* find_creature_metadata_by_ids(int creature_id){
-        for (auto creature_candidate : *creatures) {
-            if (creature_candidate->id == creature_id) {
-                return creature_candidate;
-            }
-        }
-        throw std::exception("No creature with such id.");
-    }
-
-    /// Finds evolution metadata by its id and level (or throws exception).
-    /// @param creature_id ID of a creature metadata.
-    /// @param level Level of the evolution.
-    /// @return Pointer to the evolution metadata.
-    const evolution_meta_t* find_evolution_metadata_by_ids(int creature_id, int level){
-        for (auto evolution_candidate : *evolutions) {
-            if(evolution_candidate->creature_id != creature_id) continue;
-            if(evolution_candidate->level != level) continue;
-            return evolution_candidate;
-        }
-        throw std::exception("No evolution with such id.");
-    }
-
-    /// Searches if there is an interaction between elements altering damage.
-    /// @param attacker Element of the attacker.
-    /// @param target Element of the target.
-    /// @return Damage mul. (1 for no interaction)
-    float find_element_damage_mul(element attacker, element target){
-        for(auto element_interaction : *element_interactions){
-            if(attacker != element_interaction->attacker) continue;
-            if(target != element_interaction->target) continue;
-            return element_interaction->multiplier;
-        }
-        return 1.0f;
-    }
-
-
-    namespace internal
-    {
-        void load_difficulties() {
-            auto* difficulties_temp = new vector<const difficulty_t*>;
-            std::ifstream i(difficulties_file_name);
-            while (!i.eof()){
-                auto difficulty = new difficulty_t;
-                i >> difficulty->name;
-                i >> difficulty->out_dmg_mul;
-                i >> difficulty->in_dmg_mul;
-                i >> difficulty->enemy_count;
-                i >> difficulty->player_count;
-                difficulties_temp->push_back(difficulty);
-            }
-            i.close();
-            difficulties = difficulties_temp;
-        }
-
-        void load_creatures() {
-            auto* creatures_temp = new vector<const creature_meta_t*>;
-            std::ifstream i(creatures_file_name);
-            while (!i.eof()){
-                auto creature = new creature_meta_t;
-                i >> creature->id;
-                i >> creature->name;
-
-                string element_name;
-                i >> element_name;
-                creature->element = get_element_by_name(element_name);
-                creatures_temp->push_back(creature);
-            }
-            i.close();
-            creatures = creatures_temp;
-        }
-
-
-        const evolution_meta_t* find_next_evolution(const vector<const evolution_meta_t*>* src, const evolution_meta_t* base){
-            for(auto evolution : *src){
-                if(evolution->creature_id != base->creature_id) continue;
-                if(evolution->level != base->level + 1) continue;
-                return evolution;
-            }
-            return nullptr;
-        }
-
-        void load_evolutions(){
-            auto* evolutions_temp = new vector<const evolution_meta_t*>;
-            std::ifstream i(evolutions_file_name);
-            while (!i.eof()){
-                auto evolution = new evolution_meta_t;
-
-                i >> evolution->creature_id;
-                i >> evolution->level;
-
-                i >> evolution->strength;
-                i >> evolution->max_health;
-                i >> evolution->agility;
-
-                i >> evolution->bounty_exp;
-                i >> evolution->required_exp;
-
-                int skill_type_id; i >> skill_type_id;
-                evolution->skill_type = (skill_type) skill_type_id;
-
-                i >> evolution->skill_power;
-
-                string evolution_name;
-                i >> evolution_name;
-                evolution->name = evolution_name;
-
-                evolution->next_evolution = find_next_evolution(evolutions_temp, evolution);
-
-                evolutions_temp->push_back(evolution);
-            }
-            i.close();
-            evolutions = evolutions_temp;
-        }
-
-
-        void load_element_interactions(){
-            auto nerf = element_interaction_damage_mul_nerf;
-            auto buff = element_interaction_damage_mul_buff;
-
-            element_interactions = new vector<const element_interaction_i*>{
-                new element_interaction_i{element::water, element::water, nerf },
-                new element_interaction_i{element::water, element::earth, buff },
-                new element_interaction_i{element::water, element::fire, buff },
-
-                new element_interaction_i{element::earth, element::air, nerf },
-                new element_interaction_i{element::earth, element::fire, buff },
-                new element_interaction_i{element::earth, element::ice, buff },
-                new element_interaction_i{element::earth, element::metal, buff},
-
-                new element_interaction_i{element::air, element::earth, nerf },
-                new element_interaction_i{element::air, element::ice, buff },
-                new element_interaction_i{element::air, element::metal, buff },
-
-                new element_interaction_i{element::fire, element::water, nerf },
-                new element_interaction_i{element::fire, element::earth, buff },
-                new element_interaction_i{element::fire, element::ice, buff },
-                new element_interaction_i{element::fire, element::metal, nerf },
-
-                new element_interaction_i{element::ice, element::water, nerf },
-                new element_interaction_i{element::ice, element::earth, buff },
-                new element_interaction_i{element::ice, element::fire, nerf },
-                new element_interaction_i{element::ice, element::ice, nerf },
-
-                new element_interaction_i{element::metal, element::water, buff },
-                new element_interaction_i{element::metal, element::air, buff },
-                new element_interaction_i{element::metal, element::fire, nerf },
-                new element_interaction_i{element::metal, element::metal, nerf },
-            };
-        }
-    }
-    using namespace data_importing::internal;
-
-    /// Loads game metadata from files or hard-coded data. Exceptions are not handled.
-    void init_module_importing_data(){
-        cout << "Loading difficulties";
-        load_difficulties();
-
-        cout << ", creatures";
-        load_creatures();
-
-        cout << ", evolutions";
-        load_evolutions();
-
-        cout << ", element interactions";
-        load_element_interactions();
-
-        cout << " - OK." << endl;
-    }
-}
-
-
-
-namespace buffered_numeric_io_operations{
-    /// Buffers entire file containing a list of numbers.
-    /// @param file_name Full path to the file.
-    /// @return Buffered numbers.
-    vector<int> read_buffered_numbers_file(const string& file_name){
-        ifstream i2(file_name);
-        vector<int> result;
-
-        while (!i2.eof())
-        {
-            int s; i2 >> s;
-            result.push_back(s);
-        }
-
-        i2.close();
-        return result;
-    }
-
-    // void write_buffered_numbers_file(const string& file_name, const vector<int>& values){
-    //     ofstream o2(file_name);
-    //     for (int i : values) {
-    //         o2 << i;
-    //         o2 << ' ';
-    //     }
-    //     o2.close();
-    // }
-}
-
-
-
-namespace logic{
-    using namespace data_model;
-    using namespace data_importing;
-    using namespace maths2;
-    using namespace rng;
-    using namespace events;
-
-    /// Event invoked after damaging a creature by a different creature.
-    event<damage_i> on_damage;
-    /// Event invoked after dealing enough damage_default_attack to declare a creature dead.
-    event<creature_i*> on_death;
-    /// Event invoked after a selection.
-    event<selection_i> on_selection;
-    /// Event invoked after an evolution.
-    event<creature_i*> on_evolution;
-    /// Event invoked whenever some turn is forced.
-    event<player_action> on_obligatory_turn;
-    /// Event invoked before passing defeated enemy.
-    event<int> on_enemy_pass;
-    /// Event invoked on skill use.
-    event<skill_type> on_skill_use;
-
-
-    namespace internal
-    {
-        class creature_t : public creature_i{
-        private:
-            float m_health;
-            float m_exp;
-            const creature_meta_t* m_creature_meta;
-            const evolution_meta_t* m_evolution_meta;
-
-        public:
-            /// Creates new instance of given type of creature.
-            /// @param health Initial health.
-            /// @param creature_metadata Metadata of creature type. (Not disposed)
-            /// @param evolution_metadata Metadata of initial creature evolution. (Not disposed)
-            creature_t(const creature_meta_t *creature_metadata, const evolution_meta_t *evolution_metadata, float health, float exp) :
-                    m_health(health), m_creature_meta(creature_metadata), m_evolution_meta(evolution_metadata), m_exp(exp) {}
-
-            float get_health() override { return m_health; }
-            float get_exp() override { return m_exp; }
-            bool is_alive() override { return m_health > 0; }
-            const evolution_meta_t* get_evolution() override { return m_evolution_meta; }
-            const creature_meta_t* get_creature() override { return m_creature_meta; }
-
-            void evolute() {
-                if(!can_evolute())
-                {
-                    cout << "INTERNAL ERROR: Can not evolute the creature!" << std::endl;
-                    return;
-                }
-                m_evolution_meta = m_evolution_meta->next_evolution;
-
-                auto missing_hp = m_evolution_meta->max_health - m_health;
-                m_health = m_evolution_meta->max_health - missing_hp / 2.0f;
-            }
-
-            void damage_anonymously(float p) {
-                m_health -= abs(p);
-                m_health = clamp(m_health, 0, get_evolution()->max_health);
-            }
-
-
-            void give_exp(float p) {
-                m_exp += p;
-                m_exp = clamp(m_exp, 0, get_evolution()->required_exp);
-            }
-
-            void heal_full(){
-                m_health = get_evolution()->max_health;
-            }
-        };
-
-
-
-        class team_t : public team_i{
-        private:
-            int m_selection_index;
-            vector<creature_t*> m_creatures;
-
-
-        public:
-            /// Creates team based on player picks.
-            /// @param picks Player picks. (Not disposed.)
-            explicit team_t(const vector<const creature_meta_t*>* picks) {
-                m_selection_index = 0;
-                m_creatures = vector<creature_t*>();
-                for (auto pick : *picks) {
-                    append_team(pick);
-                }
-            }
-
-            /// Creates team of random creatures and of given size.
-            /// @param team_size Number of created creatures.
-            explicit team_t(size_t team_size) {
-                m_selection_index = 0;
-                m_creatures = vector<creature_t*>();
-                for (int i = 0; i < team_size; ++i) {
-                    auto pick = find_random_creature_metadata();
-                    append_team(pick);
-                }
-            }
-
-            /// Default constructor initializing team directly.
-            /// @param selection_index Index of creature fighting on the arena.
-            /// @param creatures Pointers to creatures of the team.
-            team_t(int selection_index, const vector<creature_t*>& creatures) :
-                    m_selection_index(selection_index), m_creatures(creatures) {}
-
-            size_t get_creature_count() override { return m_creatures.size(); }
-            creature_i* get_creature(int index) override { return m_creatures.at(index); }
-            creature_i* get_selected_creature() override { return m_creatures.at(m_selection_index); }
-            int get_selected_creature_index() override { return m_selection_index; }
-
-            creature_t* get_creature_mutable(int index) { return m_creatures.at(index); }
-            creature_t* get_selected_creature_mutable() { return m_creatures.at(m_selection_index); }
-            void set_selected_creature(int index) {
-                m_selection_index = index;
-            }
-
-            bool is_defeated() override {
-                for (auto creature : m_creatures) {
-                    if(creature->is_alive()) return false;
-                }
-                return true;
-            }
-
-            bool is_creature_selectable(int index) override { return m_creatures.at(index)->is_alive(); }
-
-            ~team_t(){
-                for (auto creature : m_creatures) {
-                    delete creature;
-                }
-            }
-
-        private:
-            void append_team(const creature_meta_t *pick) {
-                auto evolution = find_default_evolution_for_creature(pick);
-                if(evolution == nullptr){
-                    cout << "INTERNAL ERROR: Creature " + pick->name + " has not init evolution!" << endl;
-                }
-                m_creatures.push_back(new creature_t(pick, evolution, evolution->max_health, 0));
-            }
-        };
-
-
-
-        class game_status_t : public game_status_i{
-        private:
-            bool m_is_player_turn;
-            int m_turn_index;
-            int m_enemy_index;
-            team_t* m_player_team;
-            vector<team_t*>* m_enemy_teams;
-
-        public:
-
-            int get_turn_index() override { return m_turn_index; }
-            bool is_player_turn() override { return m_is_player_turn; }
-
-            size_t get_enemy_teams_count() override{ return m_enemy_teams->size(); }
-            team_i* get_player_team() override { return m_player_team; }
-            team_i* get_enemy_team(int index) override{ return m_enemy_teams->at(index); }
-            team_t* get_player_team_mutable() { return m_player_team; }
-            team_t* get_enemy_team_mutable(int index){ return m_enemy_teams->at(index); }
-            int get_current_enemy_index() override { return m_enemy_index; }
-
-            /// Creates new game based on initial values.
-            /// @param player_picks Picks of the player. (Not disposed.)
-            /// @param difficulty Difficulty of the game. (Not disposed.)
-            game_status_t(
-                const vector<const struct creature_meta_t*>* player_picks,
-                const difficulty_t* difficulty)
-            {
-                m_is_player_turn = true;
-                m_turn_index = 0;
-                m_enemy_index = 0;
-
-                m_player_team = new team_t(player_picks);
-
-                m_enemy_teams = new vector<team_t*>();
-
-                for (int i = 0; i < difficulty->enemy_count; ++i) {
-                    auto new_enemy_team = new team_t(difficulty->player_count + i);
-                    m_enemy_teams->push_back(new_enemy_team);
-                }
-            }
-
-            /// Creates new game status directly.
-            /// @param is_player_turn
-            /// @param turn_index
-            /// @param enemy_team_index
-            /// @param player_team
-            /// @param enemy_teams
-            game_status_t(bool is_player_turn, int turn_index, int enemy_team_index,
-                          team_t* player_team, vector<team_t*>* enemy_teams) :
-                m_is_player_turn(is_player_turn), m_turn_index(turn_index),
-                m_enemy_index(enemy_team_index), m_player_team(player_team),
-                m_enemy_teams(enemy_teams) {}
-
-
-            bool can_make_turn_select_any_creature(bool player_team) override{
-                int available_creatures = 0;
-                for (int i = 0; i < get_team(player_team)->get_creature_count(); ++i) {
-                    if(can_make_turn_select_creature(player_team, i))
-                        available_creatures++;
-                }
-                return available_creatures > 0;
-            }
-            bool can_make_turn_select_creature(bool player_team, int selection_index) override {
-                return get_team(player_team)->is_creature_selectable(selection_index);
-            }
-            bool can_make_turn_evolute(bool player_team) override {
-                return get_team(player_team)->get_selected_creature()->can_evolute();
-            }
-            bool can_make_turn_use_attack(bool player_team) override {
-                return get_team(player_team)->get_selected_creature()->is_alive();
-            }
-            bool can_make_turn_use_skill(bool player_team) override {
-                return
-                        get_team(player_team)->get_selected_creature()->is_alive() &&
-                        get_team(player_team)->get_selected_creature()->get_evolution()->skill_type != skill_type::none;
-            }
-
-            void make_turn_select_creature(bool player_team, int selection_index) override {
-                get_team(player_team)->set_selected_creature(selection_index);
-                on_selection.invoke({selection_index, get_team(player_team)->get_selected_creature(), player_team});
-                m_turn_index++;
-            }
-            void make_turn_evolute(bool player_team) override {
-                creature_t* creature = get_team(player_team)->get_selected_creature_mutable();
-                creature->evolute();
-                on_evolution.invoke(creature);
-                m_turn_index++;
-            }
-            void make_turn_use_attack(bool player_team) override {
-                auto target = get_team(!player_team)->get_selected_creature_mutable();
-                auto attacker = get_team(player_team)->get_selected_creature_mutable();
-
-                damage_default_attack(attacker, target);
-                m_turn_index++;
-            }
-            void make_turn_use_skill(bool player_team) override {
-                team_t* target_team = get_team(!player_team);
-                team_t* attacker_team = get_team(player_team);
-                auto target = target_team->get_selected_creature_mutable();
-                auto attacker = attacker_team->get_selected_creature_mutable();
-
-                auto skill_type = attacker->get_evolution()->skill_type;
-                float skill_value = attacker->get_evolution()->skill_power / 100.0f;
-
-                on_skill_use.invoke(skill_type);
-
-                switch(skill_type) {
-                    case skill_type::none: {
-                        throw std::exception("This creature has no skill!");
-                    }
-                    case skill_type::hp_ratio_damage: {
-                        true_attack(attacker, target, target->get_health() * skill_value);
-                    }break;
-                    case skill_type::max_hp_ratio_damage:{
-                        true_attack(attacker, target, target->get_evolution()->max_health * skill_value);
-                    }break;
-                    case skill_type::massive_damage:{
-                        for (int i = 0; i < attacker_team->get_creature_count(); ++i) {
-                            auto creature = attacker_team->get_creature_mutable(i);
-                            if(!creature->is_alive()) continue;
-                            true_attack(attacker, creature, skill_value);
-                        }
-                    }break;
-                }
-                m_turn_index++;
-            }
-
-
-            bool try_make_obligatory_turn(bool player_team) override{
-                auto team = get_team(player_team);
-
-                if(!team->get_selected_creature()->is_alive() &&
-                    team->get_selectable_creature_count() == 1){
-                    for (int i = 0; i < team->get_creature_count(); ++i) {
-                        if(team->is_creature_selectable(i)) {
-                            make_turn_select_creature(player_team, i);
-                            on_obligatory_turn.invoke(player_action::creature_reselection);
-                            return true;
-                        }
-                    }
-                }
-
-                return false;
-            }
-
-            void swap_turns() override { m_is_player_turn = !m_is_player_turn; }
-
-            bool try_fight_next_enemy() override{
-                if(!get_current_enemy_team()->is_defeated())
-                    throw std::invalid_argument("Fight with next enemy team requires defeating contemporary one.");
-
-                if(get_current_enemy_index() == get_enemy_teams_count() - 1)
-                    return false;
-
-                on_enemy_pass.invoke(m_enemy_index);
-                m_enemy_index++;
-
-                {
-                    auto player_team = get_player_team_mutable();
-                    for (int i = 0; i < player_team->get_creature_count(); ++i) {
-                        auto creature = player_team->get_creature_mutable(i);
-                        creature->heal_full();
-                        creature->give_exp(5);
-                    }
-                }
-
-                return true;
-            }
-
-            ~game_status_t() override{
-                for (auto &m_enemy_team : *m_enemy_teams) {
-                    delete m_enemy_team;
-                }
-
-                delete m_enemy_teams;
-                delete m_player_team;
-
-                cout << "Disposing game - OK." << endl;
-            }
-
-        private:
-            /// Gets contemporary team involved in fight.
-            /// @param player_team Informs if the player's team is mentioned.
-            /// @return Pointer to mutable fighting team.
-            team_t* get_team(bool player_team){
-                return player_team ? m_player_team : m_enemy_teams->at(m_enemy_index);
-            }
-
-            static void true_attack(creature_t* attacker, creature_t* target, float damage){
-                target->damage_anonymously(damage);
-                on_damage.invoke({attacker, target, damage});
-
-                if(!target->is_alive()){
-                    attacker->give_exp(target->get_evolution()->bounty_exp);
-                    on_death.invoke(target);
-                }
-            }
-
-            static void damage_default_attack(creature_t* attacker, creature_t* target){
-                const float power = attacker->get_evolution()->strength;
-                const float element_mul = find_element_damage_mul(
-                        attacker->get_creature()->element,
-                        target->get_creature()->element);
-
-                float result_dmg = power * element_mul;
-
-                const float miss_possibility = 1 - (target->get_evolution()->agility / 100.0f);
-                if(rng::next_random_float_01() > miss_possibility)
-                    result_dmg = 0;
-
-                true_attack(attacker, target, result_dmg);
-            }
-        };
-
-
-        constexpr char attributes_separator = '\t';
-        constexpr char records_separator = '\n';
-        constexpr float float_to_int_mul_precision = 10.0f;
-
-        void serialize_team(ofstream& o, team_i* team, int team_id){
-            o << team->get_creature_count() << attributes_separator;
-            o << team->get_selected_creature_index() << attributes_separator;
-            o << records_separator;
-
-            for (int i = 0; i < team->get_creature_count(); ++i) {
-                auto creature = team->get_creature(i);
-                o << creature->get_creature()->id << attributes_separator;
-                o << creature->get_evolution()->level << attributes_separator;
-                o << (int)(creature->get_health() * float_to_int_mul_precision) << attributes_separator;
-                o << (int)(creature->get_exp() * float_to_int_mul_precision);
-                o << records_separator;
-            }
-        }
-    }
-    using namespace logic::internal;
-
-    namespace serialization{
-        using namespace data_importing;
-        using internal::float_to_int_mul_precision;
-
-        game_status_i* open_game(const string& save_name){
-            const string full_path = "Saves/" + save_name + ".txt";
-
-            vector<int> buffer = buffered_numeric_io_operations::read_buffered_numbers_file(full_path);
-            int buffer_i = 0;
-
-            function<int()> next_int = [&buffer_i, &buffer]() -> int{
-                return buffer.at(buffer_i++);
-            };
-            function<float()> next_float = [&next_int]() -> float{
-                float as_f = (float) (next_int());
-                return as_f / float_to_int_mul_precision;
-            };
-
-            int
-                team_count = next_int(),
-                current_enemy_index = next_int(),
-                turn_index = next_int();
-
-            bool is_player_turn = next_int() == 1;
-
-            team_t* player_team;
-            auto enemy_teams = new vector<team_t*>;
-
-            for (int j = 0; j < team_count; ++j) {
-                int team_size = next_int(), selection_index = next_int();
-
-                vector<creature_t*> creatures;
-                for (int c = 0; c < team_size; ++c) {
-                    int creature_id2 = next_int(), level2 = next_int();
-
-                    auto creature_meta = find_creature_metadata_by_ids(creature_id2);
-                    auto evolution_meta = find_evolution_metadata_by_ids(creature_id2, level2);
-
-                    float hp2 = next_float(), exp2 = next_float();
-
-                    auto new_creature = new creature_t(creature_meta, evolution_meta, hp2, exp2);
-                    creatures.push_back(new_creature);
-                }
-
-                auto new_team = new team_t(selection_index, creatures);
-
-                if(j == 0) player_team = new_team;
-                else enemy_teams->push_back(new_team);
-            }
-
-            auto result = new game_status_t(
-                is_player_turn, turn_index, current_enemy_index,
-                player_team, enemy_teams);
-
-            return result;
-        }
-
-         void save_game(const string& save_name, game_status_i* game_status){
-            cout << save_name << " saved." << records_separator;
-
-            const string full_path = "Saves/" + save_name + ".txt";
-
-            ofstream o(full_path);
-
-            o << (game_status->get_enemy_teams_count() + 1);
-            o << attributes_separator << game_status->get_current_enemy_index();
-            o << attributes_separator << game_status->get_turn_index();
-            o << attributes_separator << game_status->is_player_turn();
-            o << records_separator;
-
-            serialize_team(o, game_status->get_player_team(), 0);
-
-            for (int i = 0; i < game_status->get_enemy_teams_count(); ++i) {
-                serialize_team(o, game_status->get_enemy_team(i), i + 1);
-            }
-
-            o.close();
-        }
-    }
-
-    /// Creates new game using parsed player input.
-    /// @param player_picks Metadata(s) of desired player picks.
-    /// @param difficulty Metadata of desired difficulty.
-    /// @return New game instance.
-    game_status_i* start_new_game(const vector<const creature_meta_t*>* player_picks, const difficulty_t* difficulty) {
-        return new game_status_t(player_picks, difficulty);
-    }
-}
-
-
-
-namespace ai{
-    using namespace data_model;
-
-    player_action get_enemy_action(game_status_i* game_status){
-        vector<player_action> results;
-
-        if(game_status->can_make_turn_use_attack(false)){
-            results.push_back(player_action::attack);
-            results.push_back(player_action::attack);
-            results.push_back(player_action::attack);
-        }
-        if(game_status->can_make_turn_use_skill(false)){
-            results.push_back(player_action::skill_use);
-            results.push_back(player_action::skill_use);
-        }
-        if(game_status->can_make_turn_evolute(false)){
-            results.push_back(player_action::evolution);
-            results.push_back(player_action::evolution);
-            results.push_back(player_action::evolution);
-            results.push_back(player_action::evolution);
-            results.push_back(player_action::evolution);
-        }
-        if(game_status->get_current_enemy_team()->get_selectable_creature_count() > 1){
-            results.push_back(player_action::creature_reselection);
-        }
-
-        int random_index = rng::next_random_index(results.size());
-        return results.at(random_index);
-    }
-
-    int get_enemy_selection(game_status_i* game_status) {
-        auto team =
-                game_status->get_enemy_team(
-                        game_status->get_current_enemy_index());
-
-        vector<int> selectables;
-
-        for (int i = 0; i < team->get_creature_count(); ++i) {
-            if(team->get_selected_creature() == team->get_creature(i))
-                continue;
-            if(team->is_creature_selectable(i))
-                selectables.push_back(i);
-        }
-
-        if(selectables.empty())
-            throw std::invalid_argument("Selectables it empty!");
-
-        int random_index = rng::next_random_index(selectables.size());
-        return selectables.at(random_index);
-    }
-}
-
-
-
 namespace view{
     using namespace data_model;
 
@@ -1100,6 +60,13 @@ namespace view{
         cout << "Select difficulty:" << endl;
     }
 
+    void show_select_opponent_dialog() {
+        cout << "Select opponent:" << endl;
+        cout << "0) Random bot" << endl;
+        cout << "1) Search bot" << endl;
+        cout << "2) Expectimax bot" << endl;
+    }
+
     void show_invalid_index_answer_dialog() {
         cout << "Bruh, there is no answer with such index." << endl;
     }
@@ -1108,7 +75,7 @@ namespace view{
         cout << "Not yet implemented." << endl;
     }
 
-    void show_selected_option_dialog(const string& selection) {
+    void show_selected_option_dialog(string_view selection) {
         cout << "Selected result: " << selection << endl;
     }
 
@@ -1120,10 +87,27 @@ namespace view{
                 << endl;
     }
 
-    void show_selectable(int index, const string& value){
+    void show_selectable(int index, string_view value){
         cout << (index) << ") " << value << endl;
     }
 
+    void show_selectable_pick(int index, string_view name, float rating){
+        cout << (index) << ") " << name << " (duel score " << (int) std::lround(rating * 100) << "%)" << endl;
+    }
+
+    /// Shows what the default attack on the target is expected to do.
+    /// @param matchup Matchup of the attacker and the target.
+    /// @param target_health Health of the target.
+    /// @param target_max_health Max health of the target, whose hits to kill are looked up in the matchup.
+    void show_attack_preview(const matchup_t& matchup, float target_health, float target_max_health){
+        cout << " (" << maths2::display_float(matchup.hit_damage) << " dmg, "
+             << (int) std::lround(matchup.hit_probability * 100) << "% to hit";
+        if(matchup.hit_damage > 0)
+            cout << ", " << (target_health >= target_max_health ? matchup.hits_to_kill : matchup.get_hits_to_kill(target_health))
+                 << " hits to kill";
+        cout << ")";
+    }
+
     void show_select_team_dialog(int team_size) {
         cout
                 << "You need to create a team. Select "
@@ -1177,6 +161,10 @@ namespace view{
         }
     }
 
+    void show_turn_undone() {
+        cout << "Last turn undone." << endl;
+    }
+
     void show_turn(bool player_turn) {
         cout << endl << (player_turn ? "---* PLAYER TURN *---" : "---* COMPUTER TURN *---") << endl;
     }
@@ -1245,6 +233,32 @@ namespace view{
         cout << "0) New game" << endl;
         cout << "1) Load game" << endl;
         cout << "2) Exit" << endl;
+        cout << "3) Export save as text" << endl;
+        cout << "4) Show metrics" << endl;
+        cout << "5) Export metrics as JSON" << endl;
+    }
+
+    void show_metrics(){
+        if(!metrics::metrics_enabled){
+            cout << "Metrics are not compiled in." << endl;
+            return;
+        }
+        cout << "===[]==[ METRICS ]==[]===" << endl;
+        metrics::write_text(cout, metrics::take_snapshot());
+        cout << endl;
+    }
+
+    /// Shows allocations made during one game, if the build tracks them.
+    /// @param game_allocations Allocations made since the game started.
+    /// @param turns Turns made in the game.
+    /// @param largest_turn Allocations of the turn allocating the most.
+    void show_game_allocations(const allocations::report_t& game_allocations, long long turns,
+                               const allocations::counts_t& largest_turn){
+        if(!allocations::tracking_enabled) return;
+        cout << "===[]==[ ALLOCATIONS ]==[]===" << endl;
+        allocations::write_text(cout, game_allocations, 1, turns);
+        cout << "largest turn: " << largest_turn.allocations << " allocations, " << largest_turn.bytes << " B" << endl;
+        cout << endl;
     }
 }
 
@@ -1255,6 +269,7 @@ namespace controller{
     using namespace data_importing;
     using namespace view;
     using namespace logic;
+    using namespace logic::serialization;
     using difficulty_cp = const difficulty_t*;
     using team_picks_cp = const vector<const creature_meta_t*>*;
 
@@ -1264,19 +279,59 @@ namespace controller{
     constexpr char skill_input_key = 's';
     constexpr char evolution_input_key = 'e';
     constexpr char change_input_key = 'c';
+    constexpr char undo_input_key = 'u';
+
+    /// Sinks of events of games played in the console.
+    game_events_t game_events;
+    /// Random stream of games played in the console.
+    rng::context_t game_random(rng::random_seed());
+    enum class opponent{
+        random_bot = 0,
+        search_bot = 1,
+        expectimax_bot = 2,
+    };
+
+    /// Bot driving the enemy teams.
+    opponent game_opponent = opponent::random_bot;
+    /// Settings of the search bot.
+    ai::search_config_t search_config;
+    /// Endgame tablebase probed by the expectimax bot, generated by TurnsGame3_tablebase.
+    const string tablebase_file_name = "Endgames.tb";
+
+    /// Maps the endgame tablebase, if there is one usable with the loaded data.
+    /// @return Mapped tablebase, or null.
+    std::unique_ptr<tablebase::tablebase_t> open_tablebase(){
+        if(!ifstream(tablebase_file_name).good()) return nullptr;
+        try{
+            return std::unique_ptr<tablebase::tablebase_t>(new tablebase::tablebase_t(tablebase_file_name));
+        }
+        catch (const std::runtime_error& e) {
+            cout << tablebase_file_name << " ignored: " << e.what() << endl;
+            return nullptr;
+        }
+    }
 
     /// Asks the player what type of action he wants his creature on arena to perform.
     /// @param game_status Contemporary game status. //TODO This method is too privileged.
-    /// @return Selected player action.
-    player_action ask_for_player_action(game_status_i* game_status) {
-        if(game_status->can_make_turn_use_attack(true))
-            cout << attack_input_key << ") Use attack" << endl;
+    /// @param can_undo Informs if the player may undo his last turn.
+    /// @return Selected player action, or none when the player asked to undo his last turn.
+    player_action ask_for_player_action(game_status_i* game_status, bool can_undo) {
+        if(game_status->can_make_turn_use_attack(true)){
+            auto attacker = game_status->get_player_team()->get_selected_creature();
+            auto target = game_status->get_current_enemy_team()->get_selected_creature();
+            cout << attack_input_key << ") Use attack";
+            show_attack_preview(find_matchup(ai::get_evolution_index(attacker), ai::get_evolution_index(target)),
+                                target->get_health(), target->get_evolution()->max_health);
+            cout << endl;
+        }
         if(game_status->can_make_turn_use_skill(true))
             cout << skill_input_key << ") Use skill" << endl;
         if(game_status->can_make_turn_evolute(true))
             cout << evolution_input_key << ") Evolution" << endl;
         if(game_status->can_make_turn_select_any_creature(true))
             cout << change_input_key << ") Change creature on the arena" << endl;
+        if(can_undo)
+            cout << undo_input_key << ") Undo last turn" << endl;
 
         char input;
         player_action result = player_action::none;
@@ -1289,6 +344,10 @@ namespace controller{
                 case skill_input_key: result = player_action::skill_use; break;
                 case evolution_input_key: result = player_action::evolution; break;
                 case change_input_key: result = player_action::creature_reselection; break;
+                case undo_input_key: {
+                    if(can_undo) return player_action::none;
+                    show_invalid_index_answer_dialog();
+                } break;
                 default: {
                     show_invalid_index_answer_dialog();
                     result = player_action::none;
@@ -1347,23 +406,21 @@ namespace controller{
     /// Asks the player to select difficulty for a new game.
     /// @return Null when invalid answer was selected.
     difficulty_cp ask_for_difficulty() {
-        auto difficulties = data_importing::difficulties;
+        auto catalog = data_importing::catalog;
         show_select_difficulty_dialog();
-        for (int i = 0; i < difficulties->size(); ++i) {
-            auto difficulty = difficulties->at(i);
-            show_selectable(i, difficulty->name);
+        for (int i = 0; i < catalog->difficulty_count; ++i) {
+            show_selectable(i, catalog->difficulties[i].name);
         }
         int difficulty_index = 0;
         cin >> difficulty_index;
 
-        if(difficulty_index < 0 || difficulty_index >= difficulties->size()){
+        if(difficulty_index < 0 || difficulty_index >= catalog->difficulty_count){
             show_invalid_index_answer_dialog();
             return nullptr;
         }
 
-        show_selected_option_dialog(difficulties->at(difficulty_index)->name);
-
-        difficulty_cp result = difficulties->at(difficulty_index);
+        difficulty_cp result = &catalog->difficulties[difficulty_index];
+        show_selected_option_dialog(result->name);
         show_game_start_dialog(result->enemy_count);
 
         return result;
@@ -1373,14 +430,15 @@ namespace controller{
     /// @param team_size Number of creatures to build a team.
     /// @return Null when given answer was invalid.
     team_picks_cp ask_for_team(int team_size) {
+        allocations::scope_t scope(allocations::subsystem::console);
         show_select_team_dialog(team_size);
 
-        auto creature_types = data_importing::creatures;
-        auto creature_types_count = creature_types->size();
+        auto creature_types = data_importing::catalog->creatures;
+        auto creature_types_count = data_importing::catalog->creature_count;
 
         for (int i = 0; i < creature_types_count; ++i) {
-            auto creature = creature_types->at(i);
-            show_selectable(i, creature->name);
+            auto creature = &creature_types[i];
+            show_selectable_pick(i, creature->name, ai::rate_pick(creature));
         }
 
         auto team = new vector<const creature_meta_t*>;
@@ -1394,7 +452,7 @@ namespace controller{
                 return nullptr;
             }
 
-            team->push_back(creature_types->at(array_id));
+            team->push_back(&creature_types[array_id]);
         }
 
         show_done_dialog();
@@ -1403,6 +461,19 @@ namespace controller{
         return team;
     }
 
+    /// Asks the player to select the bot driving the enemy teams.
+    void ask_for_opponent() {
+        show_select_opponent_dialog();
+
+        int input = -1;
+        while (input < 0 || input > 2){
+            cin >> input;
+            if(input < 0 || input > 2)
+                show_invalid_index_answer_dialog();
+        }
+        game_opponent = (opponent) input;
+    }
+
     /// Asks player for settings required to create a new game and creates new game.
     /// @return New game instance.
     game_status_i* init_new_game() {
@@ -1416,7 +487,9 @@ namespace controller{
         );
         team_picks_cp player_team = keep_asking(ask_for_team_f);
 
-        return start_new_game(player_team, difficulty);
+        ask_for_opponent();
+
+        return start_new_game(player_team, difficulty, &game_random, &game_events);
     }
 
     /// Asks player if saving is required and potentially performs it.
@@ -1454,6 +527,41 @@ namespace controller{
 
         saving_func(save_name, game_status);
     }
+
+    /// Saves the game in the binary format.
+    /// @param save_name Name of the save.
+    /// @param game_status Saved game.
+    void save_game_default(const string& save_name, game_status_i* game_status){
+        try{
+            save_game_binary(save_name, game_status);
+        }
+        catch (const std::runtime_error& e) {
+            cout << "Can not save " << save_name << ": " << e.what() << endl;
+            return;
+        }
+        cout << save_name << " saved." << endl;
+    }
+
+    /// Opens the binary save, or the text one when there is no binary save of such name.
+    /// @param save_name Name of the save.
+    /// @return Restored game.
+    game_status_i* open_game_default(const string& save_name){
+        if(exists_game_binary(save_name))
+            return open_game_binary(save_name, &game_random, &game_events);
+        return open_game(save_name, &game_random, &game_events);
+    }
+
+    /// Writes metrics collected since the start as JSON.
+    /// @param file_name Name of the written file.
+    void export_metrics(const string& file_name){
+        ofstream o(file_name);
+        if(!o.is_open()){
+            cout << "Can not write " << file_name << "." << endl;
+            return;
+        }
+        metrics::write_json(o, metrics::take_snapshot());
+        cout << "Metrics written to " << file_name << "." << endl;
+    }
 }
 
 
@@ -1467,7 +575,6 @@ using namespace logic::serialization;
 using namespace view;
 using namespace controller;
 using namespace ai;
-using namespace rng;
 
 
 void static_init_modules();
@@ -1476,6 +583,8 @@ void play(game_status_i* game);
 
 
 int main() {
+    // Setting TURNS_GAME_TRACE to a file name records a trace of the session, written at exit.
+    tracing::start_from_environment();
     static_init_modules();
 
     main_menu();
@@ -1496,6 +605,7 @@ void main_menu() {
                 auto game = init_new_game();
                 play(game);
                 delete game;
+                cout << "Disposing game - OK." << endl;
 
                 show_main_menu();
             }
@@ -1507,8 +617,17 @@ void main_menu() {
                 cin >> save_name;
                 cout << "Opening save " << save_name << endl;
 
-                auto game = open_game(save_name);
-                play(game);
+                game_status_i* game = nullptr;
+                try{
+                    game = open_game_default(save_name);
+                }
+                catch (const std::exception& e) {
+                    cout << "Can not open save " << save_name << ": " << e.what() << endl;
+                }
+                if(game != nullptr){
+                    play(game);
+                    delete game;
+                }
 
                 show_main_menu();
             }break;
@@ -1517,6 +636,37 @@ void main_menu() {
                 exit = true;
             }break;
 
+            case 3: {
+                cout << "Enter save name:" << endl;
+                string save_name;
+                cin >> save_name;
+
+                // Unknown creatures throw std::exception rather than std::runtime_error, so both are caught.
+                try{
+                    std::unique_ptr<game_status_i> game(open_game_binary(save_name, &game_random, nullptr));
+                    save_game(save_name, game.get());
+                }
+                catch (const std::exception& e) {
+                    cout << "Can not export save " << save_name << ": " << e.what() << endl;
+                }
+
+                show_main_menu();
+            }break;
+
+            case 4: {
+                show_metrics();
+                show_main_menu();
+            }break;
+
+            case 5: {
+                cout << "Enter file name:" << endl;
+                string file_name;
+                cin >> file_name;
+
+                export_metrics(file_name);
+                show_main_menu();
+            }break;
+
             default: {
                 show_invalid_index_answer_dialog();
             }break;
@@ -1526,19 +676,19 @@ void main_menu() {
 
 
 void static_init_modules() {
-    on_damage.subscribe(show_creature_damaging);
-    on_death.subscribe(show_creature_death);
-    on_selection.subscribe(show_selection);
-    on_evolution.subscribe(show_evolution);
-    on_obligatory_turn.subscribe([=](player_action){
+    game_events.on_damage.subscribe<show_creature_damaging>();
+    game_events.on_death.subscribe<show_creature_death>();
+    game_events.on_selection.subscribe<show_selection>();
+    game_events.on_evolution.subscribe<show_evolution>();
+    game_events.on_obligatory_turn.subscribe([=](player_action){
         cout << "(Obligatory turn)" << endl;
     });
-    on_enemy_pass.subscribe([=](int enemy_index){
+    game_events.on_enemy_pass.subscribe([=](int enemy_index){
         cout << "--- *** --- *** ---" << endl;
         cout << "ENEMY No." << enemy_index << " DEFEATED!!!" << endl;
         cout << "--- *** --- *** ---" << endl << endl;
     });
-    on_skill_use.subscribe([=](skill_type skill_type){
+    game_events.on_skill_use.subscribe([=](skill_type skill_type){
         switch (skill_type) {
             case skill_type::hp_ratio_damage:{
                 cout << "<Current Health Ratio Damage> used!" << endl;
@@ -1553,21 +703,43 @@ void static_init_modules() {
         }
     });
 
-    init_module_rng();
+    cout << "Loading difficulties, creatures, evolutions, element interactions";
     init_module_importing_data();
+    cout << " - OK." << endl;
 }
 
 
 void play(game_status_i* game) {
+    const allocations::report_t allocations_before = allocations::take_report();
+    const int first_turn_index = game->get_turn_index();
+    allocations::counts_t largest_turn{0, 0};
+    // Searches of the bots run on copies, which are not instrumented, so only turns of this game are counted.
+    auto concrete_game = dynamic_cast<game_status_t*>(game);
+    if(concrete_game != nullptr)
+        concrete_game->set_instrumented(true);
     show_game_start_prompt();
     show_team_status2(game->get_player_team(), true);
 
     int first_selected_creature = ask_for_creature_reselection(game->get_player_team());
     game->make_turn_select_creature(true, first_selected_creature);
 
+    ai::mcts_t search_bot(search_config, game_random.next());
+    ai::expectimax_t expectimax_bot;
+    auto endgame_tablebase = open_tablebase();
+    expectimax_bot.set_tablebase(endgame_tablebase.get());
+
+    // Changes of the current round, with change counts at every decision of the player, allow undoing his turns.
+    undo_stack_t undo_stack;
+    vector<size_t> decision_marks;
+    if(concrete_game != nullptr)
+        concrete_game->set_undo_stack(&undo_stack);
 
     while (!game->is_game_over()){
+        // The round lasts till the next enemy team is fought, so it includes asking for saving.
+        tracing::span_t round_span("round");
         do{
+            // Reported per turn, dialogs and decisions of the bots included. Undone turns are left out.
+            const allocations::report_t turn_allocations_before = allocations::take_report();
             bool player_team = game->is_player_turn();
 
             if(game->is_player_turn())
@@ -1581,11 +753,34 @@ void play(game_status_i* game) {
             if(!game->try_make_obligatory_turn(player_team))
             {
                 player_action player_action;
+                ai::move_t enemy_move{};
 
                 if(game->is_player_turn()){
-                    player_action = ask_for_player_action(game);
+                    decision_marks.push_back(undo_stack.get_change_count());
+                    player_action = ask_for_player_action(game, concrete_game != nullptr && decision_marks.size() > 1);
+
+                    if(player_action == player_action::none){
+                        decision_marks.pop_back();
+                        size_t previous_decision = decision_marks.back();
+                        decision_marks.pop_back();
+
+                        while (undo_stack.get_change_count() > previous_decision){
+                            concrete_game->undo_last_change();
+                        }
+                        show_turn_undone();
+                        continue;
+                    }
+                }else if(game_opponent != opponent::random_bot){
+                    metrics::scoped_timer_t timer(metrics::timer::ai_decision);
+                    tracing::span_t span("ai_decision");
+                    enemy_move = game_opponent == opponent::search_bot ?
+                            search_bot.find_move(game) :
+                            expectimax_bot.find_move(game);
+                    player_action = enemy_move.action;
                 }else{
-                    player_action = get_enemy_action(game);
+                    metrics::scoped_timer_t timer(metrics::timer::ai_decision);
+                    tracing::span_t span("ai_decision");
+                    player_action = get_enemy_action(game, game_random);
                 }
 
                 switch (player_action) {
@@ -1593,18 +788,26 @@ void play(game_status_i* game) {
                     case player_action::skill_use: game->make_turn_use_skill(player_team); break;
                     case player_action::evolution: game->make_turn_evolute(player_team); break;
                     case player_action::creature_reselection: {
-                        int selection = player_team ?
-                            ask_for_creature_reselection(game->get_player_team()) :
-                            get_enemy_selection(game);
+                        int selection =
+                            player_team ? ask_for_creature_reselection(game->get_player_team()) :
+                            game_opponent != opponent::random_bot ? enemy_move.selection_index :
+                            get_enemy_selection(game, game_random);
                         game->make_turn_select_creature(player_team,selection);
                     } break;
                 }
             }
 
             game->swap_turns();
+
+            const allocations::counts_t turn_allocations = (allocations::take_report() - turn_allocations_before).get_total();
+            if(turn_allocations.allocations > largest_turn.allocations)
+                largest_turn = turn_allocations;
         }
         while (!game->is_round_over());
 
+        undo_stack.clear();
+        decision_marks.clear();
+
         if(game->get_player_team()->is_defeated()){
             show_round_winner(false);
         }else{
@@ -1614,8 +817,10 @@ void play(game_status_i* game) {
             if(!exists_next_enemy)
                 break;
             else
-                ask_for_saving(save_game, game);
+                ask_for_saving(save_game_default, game);
         }
     }
     show_game_winner(!game->get_player_team()->is_defeated());
+    show_game_allocations(allocations::take_report() - allocations_before, game->get_turn_index() - first_turn_index,
+                          largest_turn);
 }
\ No newline at end of file
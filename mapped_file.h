@@ -0,0 +1,104 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <stdexcept>
+
+#ifdef _WIN32
+    #ifndef WIN32_LEAN_AND_MEAN
+        #define WIN32_LEAN_AND_MEAN
+    #endif
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+using std::string;
+
+
+
+namespace memory{
+    /// Read-only view of entire file mapped into memory. The file is not copied; pages are loaded on access.
+    class mapped_file_t{
+    private:
+        const unsigned char* m_data = nullptr;
+        size_t m_size = 0;
+
+#ifdef _WIN32
+        HANDLE m_file = INVALID_HANDLE_VALUE;
+        HANDLE m_mapping = nullptr;
+#else
+        int m_descriptor = -1;
+#endif
+
+    public:
+        /// Maps the file (or throws exception).
+        /// @param file_name Full path to the file.
+        explicit mapped_file_t(const string& file_name){
+#ifdef _WIN32
+            m_file = CreateFileA(file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                 OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if(m_file == INVALID_HANDLE_VALUE)
+                throw std::runtime_error("Can not open " + file_name + ".");
+
+            LARGE_INTEGER size;
+            GetFileSizeEx(m_file, &size);
+            m_size = (size_t) size.QuadPart;
+            if(m_size == 0) return;
+
+            m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if(m_mapping == nullptr){
+                CloseHandle(m_file);
+                throw std::runtime_error("Can not map " + file_name + ".");
+            }
+            m_data = (const unsigned char*) MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+            if(m_data == nullptr){
+                CloseHandle(m_mapping);
+                CloseHandle(m_file);
+                throw std::runtime_error("Can not map " + file_name + ".");
+            }
+#else
+            m_descriptor = open(file_name.c_str(), O_RDONLY);
+            if(m_descriptor < 0)
+                throw std::runtime_error("Can not open " + file_name + ".");
+
+            struct stat status{};
+            fstat(m_descriptor, &status);
+            m_size = (size_t) status.st_size;
+            if(m_size == 0) return;
+
+            void* mapping = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, m_descriptor, 0);
+            if(mapping == MAP_FAILED){
+                close(m_descriptor);
+                throw std::runtime_error("Can not map " + file_name + ".");
+            }
+            m_data = (const unsigned char*) mapping;
+#endif
+        }
+
+        mapped_file_t(const mapped_file_t&) = delete;
+        mapped_file_t& operator=(const mapped_file_t&) = delete;
+
+        ~mapped_file_t(){
+#ifdef _WIN32
+            if(m_data != nullptr) UnmapViewOfFile(m_data);
+            if(m_mapping != nullptr) CloseHandle(m_mapping);
+            if(m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+#else
+            if(m_data != nullptr) munmap((void*) m_data, m_size);
+            if(m_descriptor >= 0) close(m_descriptor);
+#endif
+        }
+
+        /// @return First byte of the file (null for empty file).
+        const unsigned char* get_data() const { return m_data; }
+        /// @return Size of the file in bytes.
+        size_t get_size() const { return m_size; }
+    };
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cmath>
+
+
+
+namespace maths2{
+    /// Limits value to specific bounds
+    /// @param t Original value.
+    /// @param min Minimal output.
+    /// @param max Maximal output.
+    /// @return Bounded t.
+    float clamp(float t, float min, float max){
+        if(t > max) return max;
+        if(t < min) return min;
+        return t;
+    }
+
+    /// Prepares a number to be displayed to user.
+    /// @param x Original value.
+    /// @return Human-friendly value.
+    float display_float(float x){
+        if(x <= 0.1f && x > 0.0f) return 0.1f;
+        return round(x * 10) / 10;
+    }
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+
+#include "rng.h"
+#include "data_model.h"
+#include "logic.h"
+#include "ai.h"
+
+using std::vector;
+using std::uint64_t;
+
+
+
+namespace ai{
+    using namespace data_model;
+    using logic::internal::game_status_t;
+
+    /// Settings of the search bot.
+    struct search_config_t{
+        /// Playouts run for every decision.
+        int playout_budget = 20000;
+        /// Weight of exploring rarely visited moves (UCB1 constant).
+        float exploration = 1.4f;
+        /// Turns after which a playout is cut off and the round is judged by remaining health.
+        int max_playout_turns = 200;
+    };
+
+    /// Monte Carlo Tree Search bot. Plays the current round only: a playout ends when either fighting team is defeated.
+    /// The tree is open-loop (nodes are move sequences, not states), so dodges are resampled in every playout.
+    class mcts_t{
+    private:
+        struct node_t{
+            move_t move;
+            /// Side which made the move leading to the node.
+            bool player_team;
+            int parent;
+            int first_child;
+            int next_sibling;
+            int visits;
+            /// Number of times the move was legal when its parent was visited.
+            int availability;
+            /// Sum of playout rewards from the perspective of the side which made the move.
+            float reward;
+        };
+
+        search_config_t m_config;
+        rng::context_t m_random;
+        vector<node_t> m_nodes;
+        vector<move_t> m_moves;
+        /// State of the searched game, restored before every playout.
+        logic::game_snapshot_t m_root;
+
+        /// Picks move of m_moves the way the random bot does: attack 3x, skill 2x, evolution 5x, reselection 1x.
+        const move_t& pick_rollout_move(){
+            int weights = 0, reselection_count = 0;
+            for (const auto& move : m_moves) {
+                switch (move.action) {
+                    case player_action::attack: weights += 3; break;
+                    case player_action::skill_use: weights += 2; break;
+                    case player_action::evolution: weights += 5; break;
+                    default: reselection_count++; break;
+                }
+            }
+            if(reselection_count > 0) weights += 1;
+
+            int roll = m_random.next_index(weights);
+            for (const auto& move : m_moves) {
+                switch (move.action) {
+                    case player_action::attack: roll -= 3; break;
+                    case player_action::skill_use: roll -= 2; break;
+                    case player_action::evolution: roll -= 5; break;
+                    default: continue;
+                }
+                if(roll < 0) return move;
+            }
+            return m_moves[m_moves.size() - reselection_count + m_random.next_index(reselection_count)];
+        }
+
+        int find_child(int parent, const move_t& move) const {
+            for (int child = m_nodes[parent].first_child; child != -1; child = m_nodes[child].next_sibling) {
+                if(m_nodes[child].move == move) return child;
+            }
+            return -1;
+        }
+
+        int add_child(int parent, const move_t& move, bool player_team){
+            m_nodes.push_back({move, player_team, parent, -1, m_nodes[parent].first_child, 0, 1, 0});
+            m_nodes[parent].first_child = (int) m_nodes.size() - 1;
+            return m_nodes[parent].first_child;
+        }
+
+        /// Chooses among legal children of the node by UCB1, counting availability of each of them.
+        int select_child(int parent){
+            int best = -1;
+            float best_score = 0;
+            for (const auto& move : m_moves) {
+                int child = find_child(parent, move);
+                node_t& node = m_nodes[child];
+                node.availability++;
+
+                float score = node.reward / (float) node.visits +
+                        m_config.exploration * std::sqrt(std::log((float) node.availability) / (float) node.visits);
+                if(best == -1 || score > best_score){
+                    best = child;
+                    best_score = score;
+                }
+            }
+            return best;
+        }
+
+        /// Runs single playout from the root state: selection, expansion, random rollout and backpropagation.
+        /// @param game Scratch game, restored to the root state.
+        void run_playout(game_status_t* game){
+            game->restore_snapshot(m_root);
+
+            int node = 0;
+            bool expanded = false;
+            int turns = 0;
+
+            while (!game->is_round_over() && turns < m_config.max_playout_turns){
+                bool player_team = game->is_player_turn();
+
+                if(!game->try_make_obligatory_turn(player_team)){
+                    list_moves(game, player_team, m_moves);
+
+                    if(expanded){
+                        apply_move(game, player_team, pick_rollout_move());
+                    }else{
+                        int child = -1;
+                        for (const auto& move : m_moves) {
+                            if(find_child(node, move) == -1){
+                                child = add_child(node, move, player_team);
+                                expanded = true;
+                                break;
+                            }
+                        }
+                        if(child == -1) child = select_child(node);
+
+                        apply_move(game, player_team, m_nodes[child].move);
+                        node = child;
+                    }
+                }
+
+                game->swap_turns();
+                turns++;
+            }
+
+            const float player_reward = evaluate_round(game);
+            for (; node > 0; node = m_nodes[node].parent) {
+                m_nodes[node].visits++;
+                m_nodes[node].reward += m_nodes[node].player_team ? player_reward : 1 - player_reward;
+            }
+            m_nodes[0].visits++;
+        }
+
+    public:
+        /// Creates the bot.
+        /// @param config Settings of the search.
+        /// @param seed Seed of the random stream used by playouts.
+        mcts_t(const search_config_t& config, uint64_t seed) : m_config(config), m_random(seed) {}
+
+        /// Searches for the best move of the side which is to move. Obligatory turns must be made beforehand.
+        /// @param game Contemporary game status. (Not modified.)
+        /// @return Most visited move.
+        move_t find_move(game_status_t* game){
+            allocations::scope_t scope(allocations::subsystem::ai);
+            const bool player_team = game->is_player_turn();
+
+            m_nodes.clear();
+            m_nodes.reserve(m_config.playout_budget + 1);
+            m_nodes.push_back({{player_action::none, -1}, !player_team, -1, -1, -1, 0, 0, 0});
+
+            list_moves(game, player_team, m_moves);
+            if(m_moves.empty())
+                throw std::invalid_argument("There is no legal move to search.");
+            if(m_moves.size() == 1)
+                return m_moves[0];
+
+            game->save_snapshot(m_root);
+            std::unique_ptr<game_status_t> scratch(new game_status_t(m_root, &m_random));
+            for (int i = 0; i < m_config.playout_budget; ++i) {
+                run_playout(scratch.get());
+            }
+
+            int best = -1;
+            for (int child = m_nodes[0].first_child; child != -1; child = m_nodes[child].next_sibling) {
+                if(best == -1 || m_nodes[child].visits > m_nodes[best].visits)
+                    best = child;
+            }
+            return m_nodes[best].move;
+        }
+
+        /// Searches for the best move of the side which is to move.
+        /// @param game Contemporary game status. Must be created by the logic module. (Not modified.)
+        /// @return Most visited move.
+        move_t find_move(game_status_i* game){
+            auto concrete_game = dynamic_cast<game_status_t*>(game);
+            if(concrete_game == nullptr)
+                throw std::invalid_argument("Search requires game created by the logic module.");
+            return find_move(concrete_game);
+        }
+    };
+}
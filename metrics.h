@@ -0,0 +1,307 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+using std::uint64_t;
+using std::uint32_t;
+
+
+
+namespace metrics{
+#ifndef TURNS_GAME_METRICS
+    /// Enables the metrics registry. Set to 0 to compile counting and timing out.
+    #define TURNS_GAME_METRICS 1
+#endif
+
+    constexpr bool metrics_enabled = TURNS_GAME_METRICS != 0;
+
+    /// Counted events. Every evolution is made by an evolution turn, so evolutions are counted as turns.
+    enum class counter{
+        selection_turns = 0,
+        attack_turns = 1,
+        skill_turns = 2,
+        evolution_turns = 3,
+        /// Every damage dealt to a creature, dodged attacks and each target of a massive skill included.
+        damage_events = 4,
+        deaths = 5,
+    };
+    constexpr int counter_count = 6;
+    constexpr const char* counter_names[counter_count] {
+        "selection_turns", "attack_turns", "skill_turns", "evolution_turns", "damage_events", "deaths"
+    };
+
+    /// Timed operations.
+    enum class timer{
+        ai_decision = 0,
+        save = 1,
+        open = 2,
+        metadata_load = 3,
+    };
+    constexpr int timer_count = 4;
+    constexpr const char* timer_names[timer_count] {
+        "ai_decision", "save", "open", "metadata_load"
+    };
+
+    /// Bucket b holds durations of bit width b in nanoseconds: [2^(b-1), 2^b). The last one holds anything longer.
+    constexpr int bucket_count = 40;
+
+    /// Bucket of the duration.
+    /// @param ns Duration in nanoseconds.
+    /// @return Bucket index.
+    int get_bucket(uint64_t ns){
+        int bucket = 0;
+        while (ns != 0 && bucket < bucket_count - 1){
+            ns >>= 1;
+            bucket++;
+        }
+        return bucket;
+    }
+
+    /// Latency histogram of one timer, summed over all threads.
+    struct histogram_t{
+        uint64_t buckets[bucket_count];
+        uint64_t count;
+        uint64_t total_ns;
+        uint64_t max_ns;
+
+        double get_mean_ns() const { return count > 0 ? (double) total_ns / (double) count : 0; }
+
+        /// Estimates the percentile by the upper bound of the bucket it falls into.
+        /// @param fraction Percentile as fraction, e.g. 0.99.
+        /// @return Duration in nanoseconds, never more than the longest recorded one.
+        uint64_t get_percentile_ns(double fraction) const {
+            if(count == 0) return 0;
+            const uint64_t rank = (uint64_t) ((double) (count - 1) * fraction) + 1;
+            uint64_t seen = 0;
+            for (int b = 0; b < bucket_count - 1; ++b) {
+                seen += buckets[b];
+                if(seen >= rank) return std::min(b == 0 ? (uint64_t) 0 : ((uint64_t) 1 << b) - 1, max_ns);
+            }
+            return max_ns;
+        }
+    };
+
+    /// Values of all counters and timers at one moment.
+    struct snapshot_t{
+        uint64_t counters[counter_count];
+        histogram_t histograms[timer_count];
+
+        uint64_t get(counter id) const { return counters[(int) id]; }
+        const histogram_t& get(timer id) const { return histograms[(int) id]; }
+    };
+
+    namespace internal{
+        using cell_t = std::atomic<uint64_t>;
+
+        /// Adds to a cell written only by its own thread. Relaxed load and store make it a plain increment,
+        /// while readers of other threads still see whole values.
+        inline void add(cell_t& cell, uint64_t amount){
+            cell.store(cell.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+
+        struct histogram_shard_t{
+            cell_t buckets[bucket_count];
+            cell_t count;
+            cell_t total_ns;
+            cell_t max_ns;
+        };
+
+        /// Metrics of one thread. Shards outlive their threads, so counts of finished workers are kept.
+        struct shard_t{
+            cell_t counters[counter_count];
+            histogram_shard_t histograms[timer_count];
+        };
+
+        struct registry_t{
+            std::mutex mutex;
+            std::vector<std::unique_ptr<shard_t>> shards;
+        };
+
+        registry_t& get_registry(){
+            static registry_t registry;
+            return registry;
+        }
+
+        thread_local shard_t* thread_shard = nullptr;
+
+        /// Registers the shard of the calling thread on its first use.
+        shard_t* register_shard(){
+            registry_t& registry = get_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            // Value initialization zeroes the cells.
+            registry.shards.emplace_back(new shard_t());
+            thread_shard = registry.shards.back().get();
+            return thread_shard;
+        }
+
+        inline shard_t* get_shard(){
+            return thread_shard != nullptr ? thread_shard : register_shard();
+        }
+    }
+
+    /// Counts the event in the shard of the calling thread.
+    /// @param id Counted event.
+    /// @param amount Number of the events.
+    inline void count(counter id, uint64_t amount = 1){
+        if constexpr (metrics_enabled)
+            internal::add(internal::get_shard()->counters[(int) id], amount);
+    }
+
+    /// Records duration of the timed operation in the shard of the calling thread.
+    /// @param id Timed operation.
+    /// @param ns Duration in nanoseconds.
+    inline void record(timer id, uint64_t ns){
+        if constexpr (metrics_enabled){
+            auto& histogram = internal::get_shard()->histograms[(int) id];
+            internal::add(histogram.buckets[get_bucket(ns)], 1);
+            internal::add(histogram.count, 1);
+            internal::add(histogram.total_ns, ns);
+            if(ns > histogram.max_ns.load(std::memory_order_relaxed))
+                histogram.max_ns.store(ns, std::memory_order_relaxed);
+        }
+    }
+
+    /// Records time from its construction to its destruction.
+    class scoped_timer_t{
+#if TURNS_GAME_METRICS
+    private:
+        timer m_timer;
+        std::chrono::steady_clock::time_point m_start;
+
+    public:
+        explicit scoped_timer_t(timer id) : m_timer(id), m_start(std::chrono::steady_clock::now()) {}
+        ~scoped_timer_t(){
+            auto elapsed = std::chrono::steady_clock::now() - m_start;
+            record(m_timer, (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+#else
+    public:
+        explicit scoped_timer_t(timer) {}
+#endif
+
+        scoped_timer_t(const scoped_timer_t&) = delete;
+        scoped_timer_t& operator=(const scoped_timer_t&) = delete;
+    };
+
+    /// Records time from its construction to its destruction for every n-th construction on the thread.
+    /// Suits operations so short that reading the clock every time would dominate them; the histogram then
+    /// holds the samples, not all calls.
+    class sampled_timer_t{
+#if TURNS_GAME_METRICS
+    private:
+        timer m_timer;
+        bool m_is_sampled;
+        std::chrono::steady_clock::time_point m_start;
+
+        static inline thread_local uint32_t t_countdowns[timer_count] {};
+
+    public:
+        /// @param id Timed operation.
+        /// @param period Number of constructions per sample.
+        sampled_timer_t(timer id, uint32_t period) : m_timer(id) {
+            uint32_t& countdown = t_countdowns[(int) id];
+            m_is_sampled = countdown == 0;
+            countdown = m_is_sampled ? period - 1 : countdown - 1;
+            if(m_is_sampled) m_start = std::chrono::steady_clock::now();
+        }
+        ~sampled_timer_t(){
+            if(!m_is_sampled) return;
+            auto elapsed = std::chrono::steady_clock::now() - m_start;
+            record(m_timer, (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+        }
+#else
+    public:
+        sampled_timer_t(timer, uint32_t) {}
+#endif
+
+        sampled_timer_t(const sampled_timer_t&) = delete;
+        sampled_timer_t& operator=(const sampled_timer_t&) = delete;
+    };
+
+    /// Sums shards of all threads. Values written meanwhile may or may not be included.
+    /// @return Current values.
+    snapshot_t take_snapshot(){
+        snapshot_t result{};
+        auto& registry = internal::get_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        for (const auto& shard : registry.shards) {
+            for (int c = 0; c < counter_count; ++c) {
+                result.counters[c] += shard->counters[c].load(std::memory_order_relaxed);
+            }
+            for (int t = 0; t < timer_count; ++t) {
+                const auto& from = shard->histograms[t];
+                histogram_t& to = result.histograms[t];
+                for (int b = 0; b < bucket_count; ++b) {
+                    to.buckets[b] += from.buckets[b].load(std::memory_order_relaxed);
+                }
+                to.count += from.count.load(std::memory_order_relaxed);
+                to.total_ns += from.total_ns.load(std::memory_order_relaxed);
+                to.max_ns = std::max(to.max_ns, from.max_ns.load(std::memory_order_relaxed));
+            }
+        }
+        return result;
+    }
+
+    /// Zeroes all shards. Events counted by other threads during the reset may be lost.
+    void reset(){
+        auto& registry = internal::get_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        for (const auto& shard : registry.shards) {
+            for (auto& cell : shard->counters) cell.store(0, std::memory_order_relaxed);
+            for (auto& histogram : shard->histograms) {
+                for (auto& cell : histogram.buckets) cell.store(0, std::memory_order_relaxed);
+                histogram.count.store(0, std::memory_order_relaxed);
+                histogram.total_ns.store(0, std::memory_order_relaxed);
+                histogram.max_ns.store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /// Writes counters, then count, mean, p50, p99 and max of every timer in microseconds.
+    /// @param o Output stream.
+    /// @param snapshot Written values.
+    void write_text(std::ostream& o, const snapshot_t& snapshot){
+        for (int c = 0; c < counter_count; ++c) {
+            o << counter_names[c] << ": " << snapshot.counters[c] << '\n';
+        }
+        for (int t = 0; t < timer_count; ++t) {
+            const histogram_t& histogram = snapshot.histograms[t];
+            o << timer_names[t] << ": " << histogram.count << " timed"
+              << ", mean " << histogram.get_mean_ns() / 1000
+              << " us, p50 " << (double) histogram.get_percentile_ns(0.5) / 1000
+              << " us, p99 " << (double) histogram.get_percentile_ns(0.99) / 1000
+              << " us, max " << (double) histogram.max_ns / 1000 << " us\n";
+        }
+    }
+
+    /// Writes the values as JSON: {"counters": {name: value}, "timers": {name: {"count", "total_ns", "max_ns",
+    /// "buckets"}}}. Bucket b counts durations below 2^b ns, not counted in the previous buckets.
+    /// @param o Output stream.
+    /// @param snapshot Written values.
+    void write_json(std::ostream& o, const snapshot_t& snapshot){
+        o << "{\n  \"counters\": {";
+        for (int c = 0; c < counter_count; ++c) {
+            o << (c == 0 ? "\n" : ",\n") << "    \"" << counter_names[c] << "\": " << snapshot.counters[c];
+        }
+        o << "\n  },\n  \"timers\": {";
+        for (int t = 0; t < timer_count; ++t) {
+            const histogram_t& histogram = snapshot.histograms[t];
+            o << (t == 0 ? "\n" : ",\n") << "    \"" << timer_names[t] << "\": {\"count\": " << histogram.count
+              << ", \"total_ns\": " << histogram.total_ns << ", \"max_ns\": " << histogram.max_ns << ", \"buckets\": [";
+            for (int b = 0; b < bucket_count; ++b) {
+                o << (b == 0 ? "" : ", ") << histogram.buckets[b];
+            }
+            o << "]}";
+        }
+        o << "\n  }\n}\n";
+    }
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+
+#include "data_model.h"
+#include "data_importing.h"
+#include "logic.h"
+
+using std::uint8_t;
+using std::uint16_t;
+using std::uint32_t;
+
+
+
+namespace logic{
+    namespace packing{
+        using namespace data_model;
+        using internal::game_status_t;
+
+        /// Packed creature layout (32 bits): [evolution_i : 8] [hp : 12] [exp : 12].
+        /// Health and experience are quantized to float_to_int_mul_precision, like in the text save.
+        constexpr int evolution_bits = 8;
+        constexpr int health_bits = 12;
+        constexpr int exp_bits = 12;
+
+        constexpr int health_shift = evolution_bits;
+        constexpr int exp_shift = evolution_bits + health_bits;
+
+        constexpr uint32_t evolution_mask = (1u << evolution_bits) - 1;
+        constexpr uint32_t health_mask = (1u << health_bits) - 1;
+        constexpr uint32_t exp_mask = (1u << exp_bits) - 1;
+
+        constexpr float quantization = internal::float_to_int_mul_precision;
+
+        /// Current fight of a game: the player team and the current enemy team, player team first.
+        /// Occupies two cache lines and has no padding, so it may be compared and hashed bytewise.
+        struct alignas(64) packed_encounter_t{
+            static constexpr int max_creatures = 29;
+
+            uint8_t player_count;
+            uint8_t enemy_count;
+            uint8_t player_selection;
+            uint8_t enemy_selection;
+            uint16_t enemy_index;
+            uint16_t is_player_turn;
+            uint32_t turn_index;
+            uint32_t creatures[max_creatures];
+
+            int get_creature_count() const { return player_count + enemy_count; }
+
+            int get_evolution_index(int index) const { return (int) (creatures[index] & evolution_mask); }
+            float get_health(int index) const { return (float) ((creatures[index] >> health_shift) & health_mask) / quantization; }
+            float get_exp(int index) const { return (float) ((creatures[index] >> exp_shift) & exp_mask) / quantization; }
+
+            bool operator==(const packed_encounter_t& other) const {
+                return std::memcmp(this, &other, sizeof(packed_encounter_t)) == 0;
+            }
+            bool operator!=(const packed_encounter_t& other) const { return !(*this == other); }
+        };
+
+        static_assert(sizeof(packed_encounter_t) == 128, "Packed encounter must fit two cache lines.");
+
+        /// Checks if every evolution of the catalog fits the packed creature layout.
+        /// @param catalog Checked catalog. (Not disposed.)
+        /// @return False when evolution index, health or experience would be truncated.
+        bool can_pack_catalog(const catalog_t* catalog){
+            if(catalog->evolution_count > (int) evolution_mask + 1) return false;
+            for (int e = 0; e < catalog->evolution_count; ++e) {
+                const evolution_meta_t& evolution = catalog->evolutions[e];
+                if(std::lround(evolution.max_health * quantization) > (long) health_mask) return false;
+                if(std::lround(evolution.required_exp * quantization) > (long) exp_mask) return false;
+            }
+            return true;
+        }
+
+        /// Checks that the loaded catalog fits the packed creature layout (or throws exception).
+        void require_packable_catalog(){
+            if(!can_pack_catalog(data_importing::catalog))
+                throw std::length_error("Evolutions of the catalog do not fit the packed creature layout.");
+        }
+
+        /// Packs state of a creature. Every field is clamped to its bits, so it never spills into the others.
+        /// Experience past the field saturates, which still reaches required experience of a packable catalog.
+        /// @param evolution_index Catalog index of the creature evolution.
+        /// @param health Health of the creature. A living creature keeps at least one quantum, so it never packs as dead.
+        /// @param exp Experience of the creature.
+        /// @return Packed creature.
+        uint32_t pack_creature(int evolution_index, float health, float exp){
+            long health_level = std::lround(health * quantization);
+            if(health > 0 && health_level < 1) health_level = 1;
+            const long exp_level = std::lround(exp * quantization);
+
+            return ((uint32_t) evolution_index & evolution_mask) |
+                   ((uint32_t) std::clamp(health_level, 0L, (long) health_mask) << health_shift) |
+                   ((uint32_t) std::clamp(exp_level, 0L, (long) exp_mask) << exp_shift);
+        }
+
+        /// Packs the current fight of the game (or throws exception when the teams are too large).
+        /// @param game_status Packed game.
+        /// @param result Overwritten encounter.
+        void pack_encounter(game_status_t* game_status, packed_encounter_t& result){
+            auto player_team = game_status->get_player_team_mutable();
+            auto enemy_team = game_status->get_enemy_team_mutable(game_status->get_current_enemy_index());
+
+            const int player_count = (int) player_team->get_creature_count();
+            const int enemy_count = (int) enemy_team->get_creature_count();
+            if(player_count + enemy_count > packed_encounter_t::max_creatures)
+                throw std::length_error("Teams are too large to be packed.");
+
+            std::memset(&result, 0, sizeof(result));
+            result.player_count = (uint8_t) player_count;
+            result.enemy_count = (uint8_t) enemy_count;
+            result.player_selection = (uint8_t) player_team->get_selected_creature_index();
+            result.enemy_selection = (uint8_t) enemy_team->get_selected_creature_index();
+            result.enemy_index = (uint16_t) game_status->get_current_enemy_index();
+            result.is_player_turn = game_status->is_player_turn() ? 1 : 0;
+            result.turn_index = (uint32_t) game_status->get_turn_index();
+
+            for (int c = 0; c < player_count; ++c) {
+                auto creature = player_team->get_creature_mutable(c);
+                result.creatures[c] = pack_creature(creature->get_evolution_index(), creature->get_health(), creature->get_exp());
+            }
+            for (int c = 0; c < enemy_count; ++c) {
+                auto creature = enemy_team->get_creature_mutable(c);
+                result.creatures[player_count + c] = pack_creature(creature->get_evolution_index(), creature->get_health(), creature->get_exp());
+            }
+        }
+
+        /// Restores the current fight of the game to the encounter packed from this game or its copy (or throws exception).
+        /// Other enemy teams are not changed.
+        /// @param encounter Restored encounter.
+        /// @param game_status Restored game.
+        void unpack_encounter(const packed_encounter_t& encounter, game_status_t* game_status){
+            if(encounter.enemy_index >= game_status->get_enemy_teams_count())
+                throw std::invalid_argument("Encounter was packed from a game of different layout.");
+
+            auto player_team = game_status->get_player_team_mutable();
+            auto enemy_team = game_status->get_enemy_team_mutable(encounter.enemy_index);
+            if(player_team->get_creature_count() != encounter.player_count ||
+               enemy_team->get_creature_count() != encounter.enemy_count)
+                throw std::invalid_argument("Encounter was packed from a game of different layout.");
+
+            game_status->set_turn_state(encounter.is_player_turn != 0, (int) encounter.turn_index, encounter.enemy_index);
+            player_team->set_selected_creature(encounter.player_selection);
+            enemy_team->set_selected_creature(encounter.enemy_selection);
+
+            for (int c = 0; c < encounter.get_creature_count(); ++c) {
+                auto creature = c < encounter.player_count ?
+                        player_team->get_creature_mutable(c) :
+                        enemy_team->get_creature_mutable(c - encounter.player_count);
+                game_status->set_creature_state(creature, {encounter.get_evolution_index(c), encounter.get_health(c), encounter.get_exp(c)});
+            }
+        }
+    }
+}
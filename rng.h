@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <random>
+
+
+
+namespace rng{
+    using std::uint32_t;
+    using std::uint64_t;
+
+    /// Expands a seed into a well-mixed sequence of words (splitmix64).
+    /// @param state State advanced by every call.
+    /// @return Next word of the sequence.
+    constexpr uint64_t next_splitmix64(uint64_t& state){
+        uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    /// Draws a seed from the system entropy source.
+    /// @return Non-deterministic seed.
+    uint64_t random_seed(){
+        std::random_device rd2;
+        return (static_cast<uint64_t>(rd2()) << 32) ^ rd2();
+    }
+
+    /// Seedable random number generator (xoshiro256**). Every game, worker or search owns its own context.
+    class context_t{
+    private:
+        uint64_t m_state[4];
+
+        static constexpr uint64_t rotl(uint64_t x, int k){
+            return (x << k) | (x >> (64 - k));
+        }
+
+    public:
+        /// Creates new random stream.
+        /// @param seed Seed of the stream. Equal seeds give equal streams.
+        explicit context_t(uint64_t seed){
+            for (auto& word : m_state) {
+                word = next_splitmix64(seed);
+            }
+        }
+
+        /// Creates one of many independent streams sharing a seed.
+        /// @param seed Seed shared by all the streams.
+        /// @param stream_index Index of the stream.
+        context_t(uint64_t seed, uint64_t stream_index) :
+            context_t(next_splitmix64(seed) ^ (stream_index * 0xD1B54A32D192ED03ull)) {}
+
+        /// New random word.
+        /// @return Uniformly distributed 64 bits.
+        uint64_t next(){
+            const uint64_t result = rotl(m_state[1] * 5, 7) * 9;
+            const uint64_t t = m_state[1] << 17;
+
+            m_state[2] ^= m_state[0];
+            m_state[3] ^= m_state[1];
+            m_state[1] ^= m_state[2];
+            m_state[0] ^= m_state[3];
+            m_state[2] ^= t;
+            m_state[3] = rotl(m_state[3], 45);
+
+            return result;
+        }
+
+        /// New random multiplier.
+        /// @return Random number between 0 (inclusive) and 1 (exclusive).
+        float next_float_01(){
+            return static_cast<float>(next() >> 40) * (1.0f / 16777216.0f);
+        }
+
+        /// Returns index of random element. Uses multiply-shift reduction instead of division or rejection.
+        /// @param len Length of the collection.
+        /// @return Random index.
+        int next_index(size_t len){
+            const uint64_t high = next() >> 32;
+            return static_cast<int>((high * static_cast<uint32_t>(len)) >> 32);
+        }
+    };
+}
@@ -0,0 +1,251 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "rng.h"
+#include "data_model.h"
+#include "logic.h"
+#include "packed_encounter.h"
+#include "ai.h"
+
+using std::vector;
+using std::uint64_t;
+
+
+
+namespace ai{
+    using namespace data_model;
+    using logic::internal::game_status_t;
+    using logic::packing::packed_encounter_t;
+
+    /// Settings of the round solver.
+    struct round_solver_config_t{
+        /// Number of distinct states after which solving is abandoned (with exception).
+        size_t max_states = 1 << 20;
+        /// Largest change of any state value for which value iteration is considered converged.
+        double tolerance = 1e-9;
+        /// Sweeps after which value iteration stops even if not converged.
+        int max_iterations = 100000;
+    };
+
+    /// Exact solver of the current round: both sides play optimally and dodges are chance events.
+    /// Explores every state reachable from the current one (health and experience quantized as in
+    /// packed_encounter_t) and runs value iteration over the resulting graph, which has cycles, since
+    /// dodged attacks and reselections do not change health. Rounds never decided count as lost by the player.
+    class round_solver_t{
+    private:
+        struct outcome_t{
+            int next_state;
+            double probability;
+        };
+
+        struct state_hash_t{
+            size_t operator()(const packed_encounter_t& state) const {
+                uint64_t words[sizeof(packed_encounter_t) / sizeof(uint64_t)];
+                std::memcpy(words, &state, sizeof(words));
+
+                uint64_t result = 0;
+                for (uint64_t word : words) {
+                    uint64_t mixed = result ^ word;
+                    result = rng::next_splitmix64(mixed);
+                }
+                return (size_t) result;
+            }
+        };
+
+        round_solver_config_t m_config;
+
+        vector<packed_encounter_t> m_states;
+        std::unordered_map<packed_encounter_t, int, state_hash_t> m_state_indices;
+        /// Value of every state: probability that the player wins the round.
+        vector<double> m_values;
+        /// Side to move in every state.
+        vector<bool> m_player_turns;
+
+        /// Moves of a state occupy [m_move_begins[s], m_move_begins[s + 1]); outcomes of a move likewise.
+        vector<int> m_move_begins;
+        vector<move_t> m_moves;
+        vector<int> m_outcome_begins;
+        vector<outcome_t> m_outcomes;
+
+        int m_iterations = 0;
+
+        static packed_encounter_t pack_state(game_status_t* game){
+            packed_encounter_t result;
+            logic::packing::pack_encounter(game, result);
+            // Turn index does not influence the outcome of the round.
+            result.turn_index = 0;
+            return result;
+        }
+
+        /// Finds index of the state of the game, adding it when new (or throws exception when there are too many).
+        int intern_state(game_status_t* game){
+            packed_encounter_t state = pack_state(game);
+
+            auto existing = m_state_indices.find(state);
+            if(existing != m_state_indices.end()) return existing->second;
+
+            if(m_states.size() >= m_config.max_states)
+                throw std::length_error("Round has too many states to be solved.");
+
+            int index = (int) m_states.size();
+            m_states.push_back(state);
+            m_state_indices.emplace(state, index);
+            return index;
+        }
+
+        /// Adds outcome of the move made from the state: restores the state, makes the move and swaps turns.
+        void add_outcome(game_status_t* game, int state, const move_t& move, int dodge, double probability){
+            logic::packing::unpack_encounter(m_states[state], game);
+            const bool player_team = game->is_player_turn();
+
+            if(move.action == player_action::none) game->try_make_obligatory_turn(player_team);
+            else if(move.action == player_action::attack) game->make_turn_use_attack(player_team, dodge != 0);
+            else apply_move(game, player_team, move);
+            game->swap_turns();
+
+            int next_state = intern_state(game);
+            m_outcomes.push_back({next_state, probability});
+        }
+
+        /// Explores all states reachable from the game, breadth first.
+        void explore(game_status_t* game){
+            vector<move_t> moves;
+
+            for (int state = 0; state < (int) m_states.size(); ++state) {
+                logic::packing::unpack_encounter(m_states[state], game);
+                const bool player_team = game->is_player_turn();
+
+                m_move_begins.push_back((int) m_moves.size());
+                m_player_turns.push_back(player_team);
+                m_values.push_back(game->get_current_enemy_team()->is_defeated() ? 1 : 0);
+
+                if(game->is_round_over()) continue;
+
+                // Obligatory turn is stored as the only move of the state. Outcomes restore the state anyway.
+                if(game->try_make_obligatory_turn(player_team)){
+                    moves.assign(1, {player_action::none, -1});
+                }else{
+                    list_moves(game, player_team, moves);
+                }
+
+                for (const auto& move : moves) {
+                    m_outcome_begins.push_back((int) m_outcomes.size());
+                    m_moves.push_back(move);
+
+                    if(move.action != player_action::attack){
+                        add_outcome(game, state, move, 0, 1);
+                        continue;
+                    }
+
+                    logic::packing::unpack_encounter(m_states[state], game);
+                    const double dodge_probability = game->get_dodge_probability(player_team);
+                    if(dodge_probability < 1) add_outcome(game, state, move, 0, 1 - dodge_probability);
+                    if(dodge_probability > 0) add_outcome(game, state, move, 1, dodge_probability);
+                }
+            }
+            m_move_begins.push_back((int) m_moves.size());
+            m_outcome_begins.push_back((int) m_outcomes.size());
+        }
+
+        double get_move_value(int move) const {
+            double result = 0;
+            for (int o = m_outcome_begins[move]; o < m_outcome_begins[move + 1]; ++o) {
+                result += m_outcomes[o].probability * m_values[m_outcomes[o].next_state];
+            }
+            return result;
+        }
+
+        /// Index of the best move of the state (or -1 for terminal state).
+        int find_best_move(int state) const {
+            int best = -1;
+            double best_value = 0;
+            for (int m = m_move_begins[state]; m < m_move_begins[state + 1]; ++m) {
+                double value = get_move_value(m);
+                if(best == -1 || (m_player_turns[state] ? value > best_value : value < best_value)){
+                    best = m;
+                    best_value = value;
+                }
+            }
+            return best;
+        }
+
+        /// Sweeps all states in place until no value changes by more than the tolerance.
+        void iterate_values(){
+            for (m_iterations = 0; m_iterations < m_config.max_iterations; ++m_iterations) {
+                double largest_change = 0;
+                for (int state = 0; state < (int) m_states.size(); ++state) {
+                    int best = find_best_move(state);
+                    if(best == -1) continue;
+
+                    double value = get_move_value(best);
+                    largest_change = std::max(largest_change, std::abs(value - m_values[state]));
+                    m_values[state] = value;
+                }
+                if(largest_change <= m_config.tolerance) break;
+            }
+        }
+
+    public:
+        /// Creates the solver.
+        /// @param config Settings of the solver.
+        explicit round_solver_t(const round_solver_config_t& config = {}) : m_config(config) {}
+
+        /// Solves the current round of the game (or throws exception when it has too many states, or when the catalog
+        /// does not fit packed states).
+        /// @param game Contemporary game status. (Not modified.)
+        void solve(game_status_t* game){
+            logic::packing::require_packable_catalog();
+            m_states.clear();
+            m_state_indices.clear();
+            m_values.clear();
+            m_player_turns.clear();
+            m_move_begins.clear();
+            m_moves.clear();
+            m_outcome_begins.clear();
+            m_outcomes.clear();
+
+            std::unique_ptr<game_status_t> scratch(game->clone(nullptr));
+            intern_state(scratch.get());
+            explore(scratch.get());
+            iterate_values();
+        }
+
+        /// @return Probability that the player wins the solved round, with both sides playing optimally.
+        double get_win_probability() const { return m_values.empty() ? 0 : m_values[0]; }
+
+        /// @return Optimal move of the side to move in the solved round (action none for obligatory turn or decided round).
+        move_t get_best_move() const {
+            int best = m_states.empty() ? -1 : find_best_move(0);
+            return best == -1 ? move_t{player_action::none, -1} : m_moves[best];
+        }
+
+        /// Looks up the solved value of a state reachable in the solved round.
+        /// @param game Game in the state. (Not modified.)
+        /// @return Probability that the player wins the round (or -1 for state unknown to the solver).
+        double get_win_probability(game_status_t* game) const {
+            auto existing = m_state_indices.find(pack_state(game));
+            return existing == m_state_indices.end() ? -1 : m_values[existing->second];
+        }
+
+        /// Looks up the optimal move in a state reachable in the solved round.
+        /// @param game Game in the state. (Not modified.)
+        /// @return Optimal move of the side to move (action none for obligatory turn, decided round or unknown state).
+        move_t get_best_move(game_status_t* game) const {
+            auto existing = m_state_indices.find(pack_state(game));
+            int best = existing == m_state_indices.end() ? -1 : find_best_move(existing->second);
+            return best == -1 ? move_t{player_action::none, -1} : m_moves[best];
+        }
+
+        /// @return Number of distinct states of the solved round.
+        int get_state_count() const { return (int) m_states.size(); }
+        /// @return Sweeps made by value iteration.
+        int get_iteration_count() const { return m_iterations; }
+    };
+}
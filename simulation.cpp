@@ -0,0 +1,92 @@
+#include <iostream>
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <algorithm>
+
+#include "rng.h"
+#include "data_importing.h"
+#include "simulation.h"
+#include "metrics.h"
+#include "tracing.h"
+#include "allocations.h"
+
+using std::string;
+using std::cout;
+using std::endl;
+using std::uint64_t;
+
+
+
+using namespace data_model;
+using namespace data_importing;
+using namespace simulation;
+
+
+/// Finds difficulty by its name or index (or throws exception).
+/// @param key Name or index of the difficulty.
+/// @return Difficulty metadata.
+const difficulty_t* find_difficulty(const string& key){
+    for (int i = 0; i < catalog->difficulty_count; ++i) {
+        auto difficulty = &catalog->difficulties[i];
+        if(difficulty->name == key || std::to_string(i) == key)
+            return difficulty;
+    }
+    throw std::invalid_argument("No difficulty named " + key + ".");
+}
+
+void show_batch_result(const batch_result_t& result, const difficulty_t* difficulty, int thread_count, double seconds){
+    auto percent = [&result](long long count){ return 100.0 * (double) count / (double) result.games; };
+
+    cout << "Difficulty:      " << difficulty->name << endl;
+    cout << "Threads:         " << thread_count << endl;
+    cout << "Games:           " << result.games << endl;
+    cout << "Time:            " << seconds << " s" << endl;
+    cout << "Games/sec:       " << (double) result.games / seconds << endl;
+    cout << "Turns/game:      " << (double) result.turns / (double) result.games << endl;
+    cout << "Deaths/game:     " << (double) result.deaths / (double) result.games << endl;
+    cout << "Evolutions/game: " << (double) result.evolutions / (double) result.games << endl;
+    cout << "Player wins:     " << result.player_wins << " (" << percent(result.player_wins) << "%)" << endl;
+    cout << "Computer wins:   " << result.computer_wins << " (" << percent(result.computer_wins) << "%)" << endl;
+    cout << "Unfinished:      " << result.unfinished << " (" << percent(result.unfinished) << "%)" << endl;
+}
+
+
+/// Runs AI-vs-AI games without any console interaction.
+/// Usage: TurnsGame3_sim [games] [difficulty name or index] [threads] [seed] [files] [metrics|metrics-json|allocations]
+/// Passing "files" loads data files even if the game data was embedded into the build; any other word keeps the default.
+/// Passing "metrics" or "metrics-json" prints the metrics registry after the run. Passing "allocations" prints
+/// allocations of the games, which needs a build with TURNS_GAME_ALLOCATION_TRACKING.
+int main(int argc, char** argv) {
+    long long games = argc > 1 ? std::stoll(argv[1]) : 10000;
+    string difficulty_key = argc > 2 ? argv[2] : "0";
+    int thread_count = argc > 3 ? std::stoi(argv[3]) : (int) std::max(std::thread::hardware_concurrency(), 1u);
+    uint64_t seed = argc > 4 ? std::stoull(argv[4]) : rng::random_seed();
+    bool from_files = argc > 5 && string(argv[5]) == "files";
+    string report = argc > 6 ? argv[6] : "";
+    // Setting TURNS_GAME_TRACE to a file name writes a trace of the run at exit.
+    tracing::start_from_environment();
+
+    if(from_files) init_module_importing_data_from_files();
+    else init_module_importing_data();
+
+    auto difficulty = find_difficulty(difficulty_key);
+
+    const allocations::report_t allocations_before = allocations::take_report();
+    auto start = std::chrono::steady_clock::now();
+    auto result = run_parallel_batch(games, difficulty, thread_count, seed);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    const allocations::report_t game_allocations = allocations::take_report() - allocations_before;
+
+    show_batch_result(result, difficulty, thread_count, elapsed.count());
+    cout << "Seed:            " << seed << endl;
+
+    if(report == "metrics") metrics::write_text(cout, metrics::take_snapshot());
+    else if(report == "metrics-json") metrics::write_json(cout, metrics::take_snapshot());
+    else if(report == "allocations"){
+        if(allocations::tracking_enabled) allocations::write_text(cout, game_allocations, result.games, result.turns);
+        else cout << "Allocation tracking is not compiled in." << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,231 @@
+#pragma once
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+
+#include "data_model.h"
+#include "data_importing.h"
+#include "logic.h"
+#include "ai.h"
+#include "metrics.h"
+#include "tracing.h"
+
+using std::vector;
+using std::uint64_t;
+
+
+
+namespace simulation{
+    using namespace data_model;
+    using namespace data_importing;
+    using namespace logic;
+
+    /// Turns after which a simulated game is abandoned as unfinished.
+    constexpr int default_max_turns = 10000;
+    /// Number of games claimed by a worker at once.
+    constexpr long long games_per_chunk = 64;
+    /// Every n-th AI decision of a worker is timed; timing them all would almost halve the simulation speed.
+    constexpr uint32_t ai_decision_sample_period = 64;
+
+    enum class game_outcome{
+        player_win = 0,
+        computer_win = 1,
+        /// Turn limit was reached before anyone won.
+        unfinished = 2,
+    };
+
+    /// Aggregated results of many simulated games.
+    struct batch_result_t{
+        long long games;
+        long long player_wins;
+        long long computer_wins;
+        long long unfinished;
+        long long turns;
+        long long deaths;
+        long long evolutions;
+
+        /// Accumulates results of another batch.
+        /// @param other Results to be merged.
+        void merge(const batch_result_t& other){
+            games += other.games;
+            player_wins += other.player_wins;
+            computer_wins += other.computer_wins;
+            unfinished += other.unfinished;
+            turns += other.turns;
+            deaths += other.deaths;
+            evolutions += other.evolutions;
+        }
+    };
+
+    void count_death(batch_result_t& result, creature_i*){ result.deaths++; }
+    void count_evolution(batch_result_t& result, creature_i*){ result.evolutions++; }
+
+    /// Makes given sinks count deaths and evolutions into the result.
+    /// @param events Sinks of simulated games.
+    /// @param result Result accumulating the counts. (Must outlive the sinks.)
+    void subscribe_statistics(game_events_t& events, batch_result_t& result){
+        events.on_death.subscribe<count_death>(&result);
+        events.on_evolution.subscribe<count_evolution>(&result);
+    }
+
+    /// Picks random creatures for the player's team.
+    /// @param team_size Number of picked creatures.
+    /// @param random Random stream used to pick the creatures.
+    /// @return Picks of the player.
+    vector<const creature_meta_t*> pick_random_team(int team_size, rng::context_t& random){
+        vector<const creature_meta_t*> result;
+        for (int i = 0; i < team_size; ++i) {
+            result.push_back(find_random_creature_metadata(random));
+        }
+        return result;
+    }
+
+    /// Performs a single turn of the side which is to move, driven by AI.
+    /// @tparam game_t game_status_t or game_status_i.
+    /// @param game Simulated game.
+    /// @param random Random stream of the bots.
+    template<class game_t>
+    void make_ai_turn(game_t* game, rng::context_t& random){
+        bool player_team = game->is_player_turn();
+
+        if(!game->try_make_obligatory_turn(player_team))
+        {
+            player_action action;
+            {
+                metrics::sampled_timer_t timer(metrics::timer::ai_decision, ai_decision_sample_period);
+                tracing::span_t span("ai_decision");
+                action = ai::get_action(game, player_team, random);
+            }
+            switch (action) {
+                case player_action::attack: game->make_turn_use_attack(player_team); break;
+                case player_action::skill_use: game->make_turn_use_skill(player_team); break;
+                case player_action::evolution: game->make_turn_evolute(player_team); break;
+                case player_action::creature_reselection: {
+                    int selection;
+                    {
+                        metrics::sampled_timer_t timer(metrics::timer::ai_decision, ai_decision_sample_period);
+                        tracing::span_t span("ai_decision");
+                        selection = ai::get_selection(game, player_team, random);
+                    }
+                    game->make_turn_select_creature(player_team, selection);
+                } break;
+                default: break;
+            }
+        }
+
+        game->swap_turns();
+    }
+
+    /// Default turn of play_ai_game and run_batch: a single turn made by make_ai_turn.
+    struct ai_turn_t{
+        template<class game_t>
+        void operator()(game_t* game, rng::context_t& random) const { make_ai_turn(game, random); }
+    };
+
+    /// Plays the game till the end with both sides driven by AI. Mirrors the interactive loop without any I/O.
+    /// @tparam game_t game_status_t (calls bound statically) or game_status_i.
+    /// @tparam turn_t Callable as make_turn(game, random).
+    /// @param game Freshly started game.
+    /// @param random Random stream of the bots.
+    /// @param max_turns Turns after which the game is abandoned.
+    /// @param make_turn Makes every turn of the game. Wraps make_ai_turn, e.g. to time the turns.
+    /// @return Outcome of the game.
+    template<class game_t, class turn_t = ai_turn_t>
+    game_outcome play_ai_game(game_t* game, rng::context_t& random, int max_turns, const turn_t& make_turn = {}){
+        auto player_team = game->get_player_team();
+        game->make_turn_select_creature(true, random.next_index(player_team->get_creature_count()));
+
+        while (!game->is_game_over()){
+            tracing::span_t span("round");
+            do{
+                if(game->get_turn_index() >= max_turns)
+                    return game_outcome::unfinished;
+
+                make_turn(game, random);
+            }
+            while (!game->is_round_over());
+
+            if(player_team->is_defeated())
+                break;
+
+            if(!game->try_fight_next_enemy())
+                break;
+        }
+
+        return player_team->is_defeated() ? game_outcome::computer_win : game_outcome::player_win;
+    }
+
+    /// Simulates given number of games with random player picks.
+    /// @param games Number of simulated games.
+    /// @param difficulty Difficulty of every game. (Not disposed.)
+    /// @param random Random stream driving the games.
+    /// @param result Results accumulating the outcomes.
+    /// @param events Sinks of events of all the games. Null for silent games. (Not disposed.)
+    /// @param max_turns Turns after which a game is abandoned.
+    /// @param make_turn Makes every turn of the games, as in play_ai_game.
+    template<class turn_t = ai_turn_t>
+    void run_batch(long long games, const difficulty_t* difficulty, rng::context_t& random, batch_result_t& result,
+                   game_events_t* events = nullptr, int max_turns = default_max_turns, const turn_t& make_turn = {}){
+        for (long long i = 0; i < games; ++i) {
+            auto picks = pick_random_team(difficulty->player_count, random);
+            game_status_t game(&picks, difficulty, &random, events);
+            game.set_instrumented(true);
+
+            switch (play_ai_game(&game, random, max_turns, make_turn)) {
+                case game_outcome::player_win: result.player_wins++; break;
+                case game_outcome::computer_win: result.computer_wins++; break;
+                case game_outcome::unfinished: result.unfinished++; break;
+            }
+            result.turns += game.get_turn_index();
+            result.games++;
+        }
+    }
+
+    /// Simulates given number of games sharded across a pool of worker threads.
+    /// Every worker owns its random stream, event sinks and results, which are merged once all workers are done.
+    /// Each chunk of games is driven by its own stream derived from the seed, so results do not depend on scheduling.
+    /// @param games Number of simulated games.
+    /// @param difficulty Difficulty of every game. (Not disposed.)
+    /// @param thread_count Number of worker threads.
+    /// @param seed Seed of the simulation.
+    /// @param max_turns Turns after which a game is abandoned.
+    /// @return Aggregated results.
+    batch_result_t run_parallel_batch(long long games, const difficulty_t* difficulty, int thread_count,
+                                      uint64_t seed, int max_turns = default_max_turns){
+        thread_count = std::max(thread_count, 1);
+
+
+        std::atomic<long long> next_chunk{0};
+        vector<batch_result_t> worker_results(thread_count, batch_result_t{});
+        vector<std::thread> workers;
+
+        for (int w = 0; w < thread_count; ++w) {
+            workers.emplace_back([&, w](){
+                batch_result_t result{};
+                game_events_t events;
+                subscribe_statistics(events, result);
+
+                while (true){
+                    long long chunk = next_chunk.fetch_add(1);
+                    long long first = chunk * games_per_chunk;
+                    if(first >= games) break;
+
+                    rng::context_t random(seed, chunk);
+                    run_batch(std::min(games_per_chunk, games - first), difficulty, random, result, &events, max_turns);
+                }
+
+                worker_results[w] = result;
+            });
+        }
+
+        batch_result_t result{};
+        for (int w = 0; w < thread_count; ++w) {
+            workers[w].join();
+            result.merge(worker_results[w]);
+        }
+        return result;
+    }
+}
@@ -0,0 +1,195 @@
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <chrono>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include <stdexcept>
+
+#include "rng.h"
+#include "data_importing.h"
+#include "tablebase.h"
+#include "round_solver.h"
+
+using std::string;
+using std::cout;
+using std::endl;
+using std::vector;
+
+
+
+using namespace data_model;
+using namespace data_importing;
+using namespace tablebase;
+
+
+/// Finds evolution by name of its creature and level (or throws exception).
+/// @param creature_name Name of the creature.
+/// @param level Level of the evolution.
+/// @return Catalog index of the evolution.
+int find_evolution_index(const string& creature_name, int level){
+    for (int c = 0; c < catalog->creature_count; ++c) {
+        const creature_meta_t& creature = catalog->creatures[c];
+        if(creature.name == creature_name && level >= 0 && level < creature.evolution_count)
+            return creature.first_evolution + level;
+    }
+    throw std::invalid_argument("No evolution " + creature_name + " " + std::to_string(level) + ".");
+}
+
+/// Finds difficulty by its name or index (or throws exception).
+/// @param key Name or index of the difficulty.
+/// @return Difficulty metadata.
+const difficulty_t* find_difficulty(const string& key){
+    for (int i = 0; i < catalog->difficulty_count; ++i) {
+        auto difficulty = &catalog->difficulties[i];
+        if(difficulty->name == key || std::to_string(i) == key)
+            return difficulty;
+    }
+    throw std::invalid_argument("No difficulty named " + key + ".");
+}
+
+/// Finds creature by its name (or throws exception).
+/// @param creature_name Name of the creature.
+/// @return Creature metadata.
+const creature_meta_t* find_creature(const string& creature_name){
+    for (int c = 0; c < catalog->creature_count; ++c) {
+        if(catalog->creatures[c].name == creature_name)
+            return &catalog->creatures[c];
+    }
+    throw std::invalid_argument("No creature named " + creature_name + ".");
+}
+
+string get_evolution_label(int evolution_index){
+    const evolution_meta_t& evolution = catalog->evolutions[evolution_index];
+    return string(catalog->creatures[evolution.creature_index].name) + " " + string(evolution.name);
+}
+
+int generate(const string& file_name, float health_unit){
+    generator_config_t config;
+    config.health_unit = health_unit;
+
+    auto start = std::chrono::steady_clock::now();
+    auto bytes = generate_tablebase(config);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    save_tablebase(file_name, bytes);
+    cout << "Tablebase:       " << file_name << endl;
+    cout << "Size:            " << bytes.size() << " B" << endl;
+    cout << "Generated in:    " << std::fixed << std::setprecision(2) << elapsed.count() << " s" << endl;
+    return 0;
+}
+
+/// Prints chance of A to win for given states of both sides.
+int probe(const tablebase_t& table, int argc, char** argv){
+    if(argc < 9){
+        cout << "Usage: probe <file> <creature A> <level A> <health A> <creature B> <level B> <health B> [can evolve A] [can evolve B]" << endl;
+        return 1;
+    }
+    const layout_t& layout = table.get_layout();
+    const int evolution_a = find_evolution_index(argv[3], std::stoi(argv[4]));
+    const int evolution_b = find_evolution_index(argv[6], std::stoi(argv[7]));
+    const bool can_evolve_a = argc > 9 && std::stoi(argv[9]) != 0;
+    const bool can_evolve_b = argc > 10 && std::stoi(argv[10]) != 0;
+
+    const float value = table.probe(evolution_a, layout.quantize_health(evolution_a, std::stof(argv[5])), can_evolve_a,
+                                    evolution_b, layout.quantize_health(evolution_b, std::stof(argv[8])), can_evolve_b);
+    cout << get_evolution_label(evolution_a) << " (to move) vs " << get_evolution_label(evolution_b) << ": "
+         << std::fixed << std::setprecision(4) << value << endl;
+    return 0;
+}
+
+/// Prints chance of the side to move to win every matchup of fully healed evolutions.
+int show_matchups(const tablebase_t& table){
+    const layout_t& layout = table.get_layout();
+    for (int a = 0; a < layout.get_evolution_count(); ++a) {
+        cout << std::left << std::setw(24) << get_evolution_label(a);
+        for (int b = 0; b < layout.get_evolution_count(); ++b) {
+            const float value = table.probe(a, layout.get_health_levels(a) - 1, false, b, layout.get_health_levels(b) - 1, false);
+            cout << std::right << std::fixed << std::setprecision(2) << std::setw(6) << value;
+        }
+        cout << endl;
+    }
+    return 0;
+}
+
+/// Rates the player's composition: solves the first round against a random enemy team, then plays the round with
+/// both sides following the solver and fails when the share of won rounds strays from the solved chance by more than
+/// four standard errors.
+int rate_round(int argc, char** argv){
+    if(argc < 6){
+        cout << "Usage: round <difficulty> <seed> <simulated rounds> <creature>..." << endl;
+        return 1;
+    }
+    const difficulty_t* difficulty = find_difficulty(argv[2]);
+    rng::context_t random(std::stoull(argv[3]));
+    const int rounds = std::stoi(argv[4]);
+    vector<const creature_meta_t*> picks;
+    for (int i = 5; i < argc; ++i) {
+        picks.push_back(find_creature(argv[i]));
+    }
+
+    logic::internal::game_status_t game(&picks, difficulty, &random);
+    ai::round_solver_t solver;
+    auto start = std::chrono::steady_clock::now();
+    solver.solve(&game);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    // Undecided rounds count as lost, as they do for the solver.
+    constexpr int max_turns = 10000;
+    int wins = 0, unknown_states = 0;
+    for (int r = 0; r < rounds; ++r) {
+        std::unique_ptr<logic::internal::game_status_t> round(game.clone(&random));
+        for (int turn = 0; turn < max_turns && !round->is_round_over(); ++turn) {
+            const bool player_team = round->is_player_turn();
+            if(!round->try_make_obligatory_turn(player_team)){
+                const ai::move_t move = solver.get_best_move(round.get());
+                if(move.action == player_action::none){
+                    unknown_states++;
+                    break;
+                }
+                ai::apply_move(round.get(), player_team, move);
+            }
+            round->swap_turns();
+        }
+        wins += round->get_current_enemy_team()->is_defeated();
+    }
+
+    const double solved = solver.get_win_probability();
+    const double simulated = rounds > 0 ? (double) wins / rounds : 0;
+    const double tolerance = rounds > 0 ? 4 * std::sqrt(solved * (1 - solved) / rounds) : 0;
+    const bool passed = unknown_states == 0 && std::abs(simulated - solved) <= tolerance;
+
+    cout << "States:          " << solver.get_state_count() << endl;
+    cout << "Iterations:      " << solver.get_iteration_count() << endl;
+    cout << "Solved in:       " << std::fixed << std::setprecision(3) << elapsed.count() << " s" << endl;
+    cout << "Win chance:      " << std::setprecision(4) << solved << endl;
+    cout << "Simulated:       " << simulated << " of " << rounds << " rounds (tolerance " << tolerance << ")" << endl;
+    cout << "Unknown states:  " << unknown_states << endl;
+    cout << "Check:           " << (passed ? "passed" : "failed") << endl;
+    return passed ? 0 : 1;
+}
+
+int main(int argc, char** argv) {
+    string command = argc > 1 ? argv[1] : "generate";
+    string file_name = argc > 2 ? argv[2] : "Endgames.tb";
+
+    init_module_importing_data();
+
+    try{
+        if(command == "round") return rate_round(argc, argv);
+        if(command == "generate")
+            return generate(file_name, argc > 3 ? std::stof(argv[3]) : default_health_unit);
+
+        tablebase_t table(file_name);
+        if(command == "probe") return probe(table, argc, argv);
+        if(command == "matchups") return show_matchups(table);
+    }
+    catch (const std::exception& e) {
+        cout << e.what() << endl;
+        return 1;
+    }
+
+    cout << "Usage: generate [file] [health unit] | probe <file> ... | matchups [file] | round <difficulty> ..." << endl;
+    return 1;
+}
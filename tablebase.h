@@ -0,0 +1,383 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <string>
+#include <vector>
+#include <memory>
+#include <fstream>
+#include <algorithm>
+#include <stdexcept>
+
+#include "data_model.h"
+#include "data_importing.h"
+#include "logic.h"
+#include "ai.h"
+#include "mapped_file.h"
+#include "binary_serialization.h"
+
+using std::string;
+using std::vector;
+using std::uint16_t;
+using std::uint32_t;
+
+
+
+namespace tablebase{
+    using namespace data_model;
+    using namespace data_importing;
+    using logic::internal::game_status_t;
+    using logic::serialization::binary::read_u32;
+    using logic::serialization::binary::read_f32;
+    using logic::serialization::binary::write_u32;
+    using logic::serialization::binary::write_f32;
+
+    /// Tablebase layout (32-bit little-endian words, then 16-bit little-endian values):
+    /// header   [magic] [version] [evolution_c] [health_unit bits] [catalog checksum] [value_c]
+    /// evo_c x  [health_levels]
+    /// evo_c^2  [offset]                                  first value of (evolution_a, evolution_b) block
+    /// value_c x [win probability * 65535]
+    /// Every value is the chance of the side to move (A) to win the 1v1 round against B with both playing optimally.
+    /// Index of a value is offset(a, b) + ((health_a * levels_b + health_b) * 2 + can_evolve_a) * 2 + can_evolve_b.
+    constexpr uint32_t magic = 0x45334754; // "TG3E"
+    constexpr uint32_t version = 1;
+    constexpr size_t header_size = 6 * sizeof(uint32_t);
+    constexpr float default_health_unit = 1.0f;
+    constexpr double value_scale = 65535.0;
+
+    /// Checksum of everything the tablebase depends on: evolutions, elements of their creatures and element interactions.
+    /// @return FNV-1a hash.
+    uint32_t compute_catalog_checksum(){
+        uint32_t hash = logic::serialization::binary::fnv_offset_basis;
+        auto mix = [&hash](const void* data, size_t size){
+            auto bytes = (const unsigned char*) data;
+            for (size_t i = 0; i < size; ++i) {
+                hash = (hash ^ bytes[i]) * logic::serialization::binary::fnv_prime;
+            }
+        };
+
+        for (int e = 0; e < catalog->evolution_count; ++e) {
+            const evolution_meta_t& evolution = catalog->evolutions[e];
+            const float attributes[] { evolution.strength, evolution.max_health, evolution.agility,
+                                       evolution.required_exp, evolution.skill_power };
+            const int links[] { (int) evolution.skill_type, evolution.next_evolution,
+                                (int) catalog->creatures[evolution.creature_index].element };
+            mix(attributes, sizeof(attributes));
+            mix(links, sizeof(links));
+        }
+        mix(&element_damage_muls, sizeof(element_damage_muls));
+        return hash;
+    }
+
+    /// Index arithmetic shared by the generator and the reader.
+    class layout_t{
+    private:
+        int m_evolution_count = 0;
+        float m_health_unit = default_health_unit;
+        vector<uint32_t> m_health_levels;
+        vector<uint32_t> m_offsets;
+        uint32_t m_value_count = 0;
+
+    public:
+        layout_t() = default;
+
+        /// Computes the layout for the loaded catalog.
+        /// @param health_unit Health represented by one quantization level.
+        explicit layout_t(float health_unit) : m_evolution_count(catalog->evolution_count), m_health_unit(health_unit) {
+            for (int e = 0; e < m_evolution_count; ++e) {
+                m_health_levels.push_back((uint32_t) std::ceil(catalog->evolutions[e].max_health / health_unit) + 1);
+            }
+            for (int a = 0; a < m_evolution_count; ++a) {
+                for (int b = 0; b < m_evolution_count; ++b) {
+                    m_offsets.push_back(m_value_count);
+                    m_value_count += m_health_levels[a] * m_health_levels[b] * 4;
+                }
+            }
+        }
+
+        /// Reads the layout of a tablebase (or throws exception).
+        /// @param data First byte of the tablebase.
+        /// @param size Size of the tablebase in bytes.
+        layout_t(const unsigned char* data, size_t size){
+            if(data == nullptr || size < header_size || read_u32(data) != magic)
+                throw std::runtime_error("Not a tablebase.");
+            if(read_u32(data + 4) != version)
+                throw std::runtime_error("Unsupported tablebase version.");
+
+            m_evolution_count = (int) read_u32(data + 8);
+            m_health_unit = read_f32(data + 12);
+            m_value_count = read_u32(data + 20);
+
+            if(size != get_file_size())
+                throw std::runtime_error("Tablebase has invalid size.");
+
+            const unsigned char* word = data + header_size;
+            for (int e = 0; e < m_evolution_count; ++e, word += 4) m_health_levels.push_back(read_u32(word));
+            for (int p = 0; p < m_evolution_count * m_evolution_count; ++p, word += 4) m_offsets.push_back(read_u32(word));
+        }
+
+        int get_evolution_count() const { return m_evolution_count; }
+        float get_health_unit() const { return m_health_unit; }
+        uint32_t get_health_levels(int evolution_index) const { return m_health_levels[evolution_index]; }
+        uint32_t get_value_count() const { return m_value_count; }
+
+        size_t get_values_offset() const {
+            return header_size + (m_evolution_count + (size_t) m_evolution_count * m_evolution_count) * sizeof(uint32_t);
+        }
+        size_t get_file_size() const { return get_values_offset() + (size_t) m_value_count * sizeof(uint16_t); }
+
+        /// Quantizes health. Living creature never gets level 0.
+        uint32_t quantize_health(int evolution_index, float health) const {
+            if(health <= 0) return 0;
+            auto level = (uint32_t) std::ceil(health / m_health_unit - 0.001f);
+            return std::min(std::max(level, 1u), m_health_levels[evolution_index] - 1);
+        }
+
+        /// Health represented by the quantization level.
+        float get_health(int evolution_index, uint32_t level) const {
+            return std::min(level * m_health_unit, catalog->evolutions[evolution_index].max_health);
+        }
+
+        uint32_t get_index(int evolution_a, uint32_t health_a, bool can_evolve_a,
+                           int evolution_b, uint32_t health_b, bool can_evolve_b) const {
+            return m_offsets[evolution_a * m_evolution_count + evolution_b] +
+                   ((health_a * m_health_levels[evolution_b] + health_b) * 2 + (can_evolve_a ? 1 : 0)) * 2 + (can_evolve_b ? 1 : 0);
+        }
+
+        void write_header(unsigned char* data) const {
+            write_u32(data, magic);
+            write_u32(data + 4, version);
+            write_u32(data + 8, (uint32_t) m_evolution_count);
+            write_f32(data + 12, m_health_unit);
+            write_u32(data + 16, compute_catalog_checksum());
+            write_u32(data + 20, m_value_count);
+
+            unsigned char* word = data + header_size;
+            for (uint32_t levels : m_health_levels) { write_u32(word, levels); word += 4; }
+            for (uint32_t offset : m_offsets) { write_u32(word, offset); word += 4; }
+        }
+    };
+
+    /// Settings of the generator.
+    struct generator_config_t{
+        float health_unit = default_health_unit;
+        /// Largest change of any value for which the analysis is considered converged.
+        double tolerance = 1e-7;
+        int max_iterations = 10000;
+    };
+
+    namespace internal{
+        /// Outcome of a move. Next state is seen from the side of B, which moves next.
+        struct outcome_t{
+            /// Index of the next state, or -1 when A wins by the move, or -2 when A loses by it.
+            int next_state;
+            float probability;
+        };
+
+        struct state_t{
+            /// Index of the first move of the state. Moves of a state end where moves of the next state begin.
+            int first_move;
+            /// Evolution stages of both creatures and sum of their health levels, giving the order of the analysis.
+            int stage;
+            int health;
+        };
+
+        /// Sets the creature of the scratch game to the quantized state.
+        void set_creature(game_status_t* game, bool player_team, const layout_t& layout,
+                          int evolution_index, uint32_t health, bool can_evolve){
+            auto team = player_team ? game->get_player_team_mutable() : game->get_enemy_team_mutable(0);
+            const evolution_meta_t& evolution = catalog->evolutions[evolution_index];
+            // Experience only changes by killing, which ends the round, so it is either full or irrelevant.
+            game->set_creature_state(team->get_creature_mutable(0), {evolution_index, layout.get_health(evolution_index, health),
+                                                                     can_evolve ? evolution.required_exp : 0});
+        }
+    }
+
+    /// Generates the tablebase for the loaded catalog by retrograde analysis: states are swept in order of
+    /// decreasing evolution stage and increasing health, so most successors are final before their predecessors;
+    /// sweeps repeat until the values of mutual dodges converge.
+    /// @param config Settings of the generator.
+    /// @return Bytes of the tablebase file.
+    vector<unsigned char> generate_tablebase(const generator_config_t& config = {}){
+        using namespace internal;
+
+        const layout_t layout(config.health_unit);
+        const uint32_t state_count = layout.get_value_count();
+
+        vector<state_t> states(state_count);
+        vector<outcome_t> outcomes;
+        vector<int> outcome_begins;
+        vector<double> values(state_count, 0);
+
+        std::unique_ptr<game_status_t> game(new game_status_t(true, 0, 0, 2, 2, nullptr));
+        game->append_creature(game->append_team(0), 0, 1, 0);
+        game->append_creature(game->append_team(0), 0, 1, 0);
+
+        vector<ai::move_t> moves;
+        auto read_outcome = [&](float probability) -> outcome_t {
+            auto a = game->get_player_team_mutable()->get_creature_mutable(0);
+            auto b = game->get_enemy_team_mutable(0)->get_creature_mutable(0);
+            if(!b->is_alive()) return {-1, probability};
+            if(!a->is_alive()) return {-2, probability};
+
+            const int evolution_a = a->get_evolution_index(), evolution_b = b->get_evolution_index();
+            return {(int) layout.get_index(
+                    evolution_b, layout.quantize_health(evolution_b, b->get_health()), b->can_evolute(),
+                    evolution_a, layout.quantize_health(evolution_a, a->get_health()), a->can_evolute()), probability};
+        };
+
+        for (int a = 0; a < layout.get_evolution_count(); ++a) {
+            for (int b = 0; b < layout.get_evolution_count(); ++b) {
+                for (uint32_t health_a = 0; health_a < layout.get_health_levels(a); ++health_a) {
+                    for (uint32_t health_b = 0; health_b < layout.get_health_levels(b); ++health_b) {
+                        for (int flags = 0; flags < 4; ++flags) {
+                            const bool can_evolve_a = (flags & 2) != 0, can_evolve_b = (flags & 1) != 0;
+                            const uint32_t index = layout.get_index(a, health_a, can_evolve_a, b, health_b, can_evolve_b);
+
+                            states[index] = {(int) outcome_begins.size(),
+                                             -(catalog->evolutions[a].level + catalog->evolutions[b].level),
+                                             (int) (health_a + health_b)};
+                            if(health_a == 0 || health_b == 0){
+                                values[index] = health_b == 0 ? 1 : 0;
+                                continue;
+                            }
+
+                            set_creature(game.get(), true, layout, a, health_a, can_evolve_a);
+                            set_creature(game.get(), false, layout, b, health_b, can_evolve_b);
+                            ai::list_moves(game.get(), true, moves);
+
+                            for (const auto& move : moves) {
+                                outcome_begins.push_back((int) outcomes.size());
+
+                                const float dodge_probability = move.action == player_action::attack ? game->get_dodge_probability(true) : 0;
+                                for (int dodged = 0; dodged < 2; ++dodged) {
+                                    const float probability = dodged ? dodge_probability : 1 - dodge_probability;
+                                    if(probability <= 0) continue;
+
+                                    set_creature(game.get(), true, layout, a, health_a, can_evolve_a);
+                                    set_creature(game.get(), false, layout, b, health_b, can_evolve_b);
+                                    if(move.action == player_action::attack) game->make_turn_use_attack(true, dodged != 0);
+                                    else ai::apply_move(game.get(), true, move);
+                                    outcomes.push_back(read_outcome(probability));
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+        const int move_count = (int) outcome_begins.size();
+        outcome_begins.push_back((int) outcomes.size());
+
+        vector<int> order(state_count);
+        for (uint32_t i = 0; i < state_count; ++i) order[i] = (int) i;
+        std::stable_sort(order.begin(), order.end(), [&states](int x, int y){
+            return states[x].stage != states[y].stage ? states[x].stage < states[y].stage : states[x].health < states[y].health;
+        });
+
+        auto get_move_value = [&](int move) -> double {
+            double result = 0;
+            for (int o = outcome_begins[move]; o < outcome_begins[move + 1]; ++o) {
+                const outcome_t& outcome = outcomes[o];
+                result += outcome.probability * (outcome.next_state == -1 ? 1.0 : outcome.next_state == -2 ? 0.0 : 1 - values[outcome.next_state]);
+            }
+            return result;
+        };
+
+        for (int iteration = 0; iteration < config.max_iterations; ++iteration) {
+            double largest_change = 0;
+            for (int index : order) {
+                const int first_move = states[index].first_move;
+                // States were generated in index order, so moves of a state end where moves of the next one begin.
+                const int end_move = index + 1 < (int) state_count ? states[index + 1].first_move : move_count;
+                if(first_move == end_move) continue;
+
+                double best = 0;
+                for (int m = first_move; m < end_move; ++m) {
+                    best = std::max(best, get_move_value(m));
+                }
+                largest_change = std::max(largest_change, std::abs(best - values[index]));
+                values[index] = best;
+            }
+            if(largest_change <= config.tolerance) break;
+        }
+
+        vector<unsigned char> result(layout.get_file_size());
+        layout.write_header(result.data());
+        unsigned char* value = result.data() + layout.get_values_offset();
+        for (double v : values) {
+            auto scaled = (uint16_t) std::lround(std::min(std::max(v, 0.0), 1.0) * value_scale);
+            value[0] = (unsigned char) scaled;
+            value[1] = (unsigned char) (scaled >> 8);
+            value += sizeof(uint16_t);
+        }
+        return result;
+    }
+
+    /// Writes the tablebase file.
+    /// @param file_name Full path to the file.
+    /// @param bytes Bytes of the tablebase.
+    void save_tablebase(const string& file_name, const vector<unsigned char>& bytes){
+        std::ofstream o(file_name, std::ios::binary);
+        if(!o.is_open())
+            throw std::runtime_error("Can not write " + file_name + ".");
+        o.write((const char*) bytes.data(), (std::streamsize) bytes.size());
+        o.close();
+    }
+
+    /// Tablebase mapped into memory. Probing costs one index computation and one 16-bit load.
+    class tablebase_t{
+    private:
+        memory::mapped_file_t m_file;
+        layout_t m_layout;
+        const unsigned char* m_values;
+
+    public:
+        /// Maps the tablebase (or throws exception when it is malformed or generated for different data).
+        /// @param file_name Full path to the file.
+        explicit tablebase_t(const string& file_name) :
+            m_file(file_name), m_layout(m_file.get_data(), m_file.get_size()) {
+            if(m_layout.get_evolution_count() != catalog->evolution_count ||
+               read_u32(m_file.get_data() + 16) != compute_catalog_checksum())
+                throw std::runtime_error("Tablebase was generated for different game data.");
+            m_values = m_file.get_data() + m_layout.get_values_offset();
+        }
+
+        const layout_t& get_layout() const { return m_layout; }
+
+        /// Probes quantized state directly.
+        /// @return Chance of A (the side to move) to win.
+        float probe(int evolution_a, uint32_t health_a, bool can_evolve_a,
+                    int evolution_b, uint32_t health_b, bool can_evolve_b) const {
+            const unsigned char* value = m_values + (size_t) 2 * m_layout.get_index(
+                    evolution_a, health_a, can_evolve_a, evolution_b, health_b, can_evolve_b);
+            return (float) (value[0] | (value[1] << 8)) / (float) value_scale;
+        }
+
+        /// Probes the current round of the game.
+        /// @param game Contemporary game status.
+        /// @return Chance of the side to move to win the round, or -1 unless each side has one living creature on the arena.
+        float probe(game_status_i* game) const {
+            if(game->is_round_over()) return -1;
+
+            team_i* teams[] { game->get_player_team(), game->get_current_enemy_team() };
+            creature_i* creatures[2];
+            for (int t = 0; t < 2; ++t) {
+                creatures[t] = teams[t]->get_selected_creature();
+                if(!creatures[t]->is_alive()) return -1;
+
+                for (int c = 0; c < (int) teams[t]->get_creature_count(); ++c) {
+                    if(c != teams[t]->get_selected_creature_index() && teams[t]->get_creature(c)->is_alive()) return -1;
+                }
+            }
+
+            creature_i* a = creatures[game->is_player_turn() ? 0 : 1];
+            creature_i* b = creatures[game->is_player_turn() ? 1 : 0];
+            const int evolution_a = (int) (a->get_evolution() - catalog->evolutions);
+            const int evolution_b = (int) (b->get_evolution() - catalog->evolutions);
+            return probe(evolution_a, m_layout.quantize_health(evolution_a, a->get_health()), a->can_evolute(),
+                         evolution_b, m_layout.quantize_health(evolution_b, b->get_health()), b->can_evolute());
+        }
+    };
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::int64_t;
+using std::uint64_t;
+
+
+
+namespace tracing{
+#ifndef TURNS_GAME_TRACING
+    /// Compiles the spans in. They record only after start is called. Set to 0 to compile them out.
+    #define TURNS_GAME_TRACING 1
+#endif
+
+    constexpr bool tracing_enabled = TURNS_GAME_TRACING != 0;
+
+    /// Environment variable naming the trace file written at exit.
+    constexpr const char* trace_file_variable = "TURNS_GAME_TRACE";
+    /// Spans kept per thread. Older spans are overwritten by newer ones.
+    constexpr size_t default_ring_capacity = 1 << 16;
+
+    /// Finished span, timed from the start of the trace.
+    struct span_record_t{
+        /// Name of the span. (String literal, not copied.)
+        const char* name;
+        int64_t start_ns;
+        int64_t duration_ns;
+    };
+
+    namespace internal{
+        /// Spans of one thread. Only the owning thread writes, so appending takes no lock.
+        struct ring_t{
+            std::vector<span_record_t> records;
+            /// Number of spans ever appended; the next one goes to head modulo capacity.
+            std::atomic<uint64_t> head{0};
+            int thread_id;
+        };
+
+        struct registry_t{
+            std::mutex mutex;
+            std::vector<std::unique_ptr<ring_t>> rings;
+            string file_name;
+            size_t ring_capacity = default_ring_capacity;
+            std::chrono::steady_clock::time_point epoch;
+        };
+
+        registry_t& get_registry(){
+            static registry_t registry;
+            return registry;
+        }
+
+        std::atomic<bool> is_recording{false};
+        thread_local ring_t* thread_ring = nullptr;
+
+        /// Registers the ring of the calling thread on its first span.
+        ring_t* register_ring(){
+            registry_t& registry = get_registry();
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            auto ring = new ring_t;
+            ring->records.resize(registry.ring_capacity);
+            ring->thread_id = (int) registry.rings.size() + 1;
+            registry.rings.emplace_back(ring);
+            thread_ring = ring;
+            return ring;
+        }
+
+        inline int64_t now_ns(){
+            auto elapsed = std::chrono::steady_clock::now() - get_registry().epoch;
+            return (int64_t) std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+        }
+
+        void append(const char* name, int64_t start_ns, int64_t end_ns){
+            ring_t* ring = thread_ring != nullptr ? thread_ring : register_ring();
+            const uint64_t head = ring->head.load(std::memory_order_relaxed);
+            ring->records[head % ring->records.size()] = {name, start_ns, end_ns - start_ns};
+            ring->head.store(head + 1, std::memory_order_release);
+        }
+    }
+
+    /// Writes spans of all threads as Chrome trace events, loadable by chrome://tracing and Perfetto.
+    /// Threads still recording meanwhile may leave their newest spans out.
+    /// @param o Output stream.
+    void write_chrome_trace(std::ostream& o){
+        auto& registry = internal::get_registry();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+
+        o << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+        bool first = true;
+        for (const auto& ring : registry.rings) {
+            o << (first ? "\n" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << ring->thread_id
+              << ", \"args\": {\"name\": \"thread " << ring->thread_id << "\"}}";
+            first = false;
+
+            const uint64_t head = ring->head.load(std::memory_order_acquire);
+            const uint64_t capacity = ring->records.size();
+            for (uint64_t i = head > capacity ? head - capacity : 0; i < head; ++i) {
+                const span_record_t& record = ring->records[i % capacity];
+                o << ",\n{\"name\": \"" << record.name << "\", \"cat\": \"game\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << ring->thread_id
+                  << std::fixed << std::setprecision(3)
+                  << ", \"ts\": " << (double) record.start_ns / 1000
+                  << ", \"dur\": " << (double) record.duration_ns / 1000 << "}";
+            }
+        }
+        o << "\n]}\n";
+    }
+
+    /// Writes the trace file named by start. Called at exit.
+    void flush(){
+        internal::is_recording.store(false, std::memory_order_relaxed);
+        const string& file_name = internal::get_registry().file_name;
+
+        std::ofstream o(file_name);
+        if(!o.is_open()){
+            std::cout << "Can not write trace " << file_name << "." << std::endl;
+            return;
+        }
+        write_chrome_trace(o);
+        std::cout << "Trace written to " << file_name << "." << std::endl;
+    }
+
+    /// Starts recording spans, written to the file at exit. Does nothing when tracing is compiled out
+    /// or already started.
+    /// @param file_name Name of the trace file.
+    /// @param ring_capacity Spans kept per thread.
+    void start(const string& file_name, size_t ring_capacity = default_ring_capacity){
+        if(!tracing_enabled || internal::is_recording.load()) return;
+
+        // The registry is constructed before flush is registered, so it is destroyed only after flush runs.
+        auto& registry = internal::get_registry();
+        registry.file_name = file_name;
+        registry.ring_capacity = ring_capacity > 0 ? ring_capacity : 1;
+        registry.epoch = std::chrono::steady_clock::now();
+        std::atexit(flush);
+        internal::is_recording.store(true, std::memory_order_release);
+    }
+
+    /// Starts recording when the environment variable names the trace file.
+    /// @return True if recording started.
+    bool start_from_environment(){
+        const char* file_name = std::getenv(trace_file_variable);
+        if(file_name == nullptr || *file_name == '\0') return false;
+        start(file_name);
+        return tracing_enabled;
+    }
+
+    /// Records time from its construction to its destruction as a span of the calling thread.
+    class span_t{
+#if TURNS_GAME_TRACING
+    private:
+        const char* m_name = nullptr;
+        int64_t m_start_ns = 0;
+
+    public:
+        /// @param name Name of the span. (String literal, not copied.)
+        /// @param is_traced False skips the span, e.g. for turns of games copied by AI searches.
+        explicit span_t(const char* name, bool is_traced = true){
+            if(!is_traced || !internal::is_recording.load(std::memory_order_acquire)) return;
+            m_name = name;
+            m_start_ns = internal::now_ns();
+        }
+        ~span_t(){
+            if(m_name != nullptr) internal::append(m_name, m_start_ns, internal::now_ns());
+        }
+#else
+    public:
+        explicit span_t(const char*, bool = true) {}
+#endif
+
+        span_t(const span_t&) = delete;
+        span_t& operator=(const span_t&) = delete;
+    };
+}